@@ -142,7 +142,7 @@ static inline int ASM_CALL_cc_nn(CPU* cpu, Memory* mem, int ccCode) {
             break;
     }
     if (cond) {
-        uint16_t jumpAddress = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
+        uint16_t jumpAddress = MEM_getWord(mem, cpu->PC + 1);
         uint16_t nextAddress = cpu->PC + 3;
         MEM_pushToStack(mem, &(cpu->SP), nextAddress);
         cpu->PC = jumpAddress;
@@ -155,7 +155,7 @@ static inline int ASM_CALL_cc_nn(CPU* cpu, Memory* mem, int ccCode) {
 
 // CALL nn: Push address of next instruction onto stack, then jump to nn
 static inline void ASM_CALL_nn(CPU* cpu, Memory* mem) {
-    uint16_t jumpAddress = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
+    uint16_t jumpAddress = MEM_getWord(mem, cpu->PC + 1);
     uint16_t nextAddress = cpu->PC + 3;
     MEM_pushToStack(mem, &(cpu->SP), nextAddress);
     cpu->PC = jumpAddress;
@@ -293,7 +293,7 @@ static inline int ASM_JP_cc_nn(CPU* cpu, Memory* mem, int ccCode) {
             break;
     }
     if (cond) {
-        cpu->PC = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
+        cpu->PC = MEM_getWord(mem, cpu->PC + 1);
         return 1;
     } else {
         cpu->PC += 3;
@@ -308,7 +308,7 @@ static inline void ASM_JP_HL(CPU* cpu) {
 
 // JP nn: Jump to address in next 2 bytes
 static inline void ASM_JP_nn(CPU* cpu, Memory* mem) {
-    cpu->PC = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
+    cpu->PC = MEM_getWord(mem, cpu->PC + 1);
 }
 
 // JR cc, n: Add next byte to PC if cc condition met
@@ -387,16 +387,14 @@ static inline void ASM_LD_nn_n(CPU* cpu, Memory* mem, uint8_t* reg) {
 
 // LD (nn), SP: Load SP into address contained in next 2 bytes
 static inline void ASM_LD_nn_SP(CPU* cpu, Memory* mem) {
-    //cpu->SP = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
-    uint16_t address = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
-    MEM_setByte(mem, address, cpu->SP & 0xFF);
-    MEM_setByte(mem, address + 1, (cpu->SP & 0xFF00) >> 8);
+    uint16_t address = MEM_getWord(mem, cpu->PC + 1);
+    MEM_setWord(mem, address, cpu->SP);
     cpu->PC += 3;
 }
 
 // LD n, nn: Load next 2 bytes into 16-bit register
 static inline void ASM_LD_n_nn(CPU* cpu, Memory* mem, uint16_t* reg) {
-    *reg = (MEM_getByte(mem, cpu->PC + 2) << 8) | MEM_getByte(mem, cpu->PC + 1);
+    *reg = MEM_getWord(mem, cpu->PC + 1);
     if (reg == &(cpu->AF)) cpu->F &= 0xF0;
     cpu->PC += 3;
 }
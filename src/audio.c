@@ -14,8 +14,10 @@
 #endif
 
 void audioCallback(void* user_data, uint8_t* raw_buffer, int bytes);
+static void updateFrequencies(Audio* audio, Memory* mem);
+static void writeFrequencyRegister(void* context, Memory* mem, uint16_t address, uint8_t value);
 
-void AUD_init(Audio* audio, int sampleRate) {
+void AUD_init(Audio* audio, Memory* mem, int sampleRate) {
     SDL_Init(SDL_INIT_AUDIO);
 
     audio->sampleRate = sampleRate;
@@ -40,6 +42,23 @@ void AUD_init(Audio* audio, int sampleRate) {
     audio->deviceId = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_ANY_CHANGE);
 
     SDL_PauseAudioDevice(audio->deviceId, false);
+
+    // Recompute channel frequencies whenever a register they depend on is written
+    uint16_t registers[] = {REG_NR13, REG_NR14, REG_NR23, REG_NR24, REG_NR30, REG_NR33, REG_NR34};
+    for (size_t i = 0; i < sizeof(registers) / sizeof(registers[0]); ++i) {
+        MEM_setIoHook(mem, registers[i], NULL, writeFrequencyRegister, audio);
+    }
+    updateFrequencies(audio, mem);
+}
+
+// Silence the channels after a power cycle and pick up the reset registers
+void AUD_reset(Audio* audio, Memory* mem) {
+    SDL_LockAudioDevice(audio->deviceId);
+    for (int i = 0; i < 4; ++i) {
+        audio->channels[i].time = 0.0;
+    }
+    updateFrequencies(audio, mem);
+    SDL_UnlockAudioDevice(audio->deviceId);
 }
 
 void AUD_destroy(Audio* audio) {
@@ -49,22 +68,27 @@ void AUD_destroy(Audio* audio) {
     audio = NULL;
 }
 
-void AUD_update(Audio* audio, Memory* mem) {
+static void updateFrequencies(Audio* audio, Memory* mem) {
     unsigned int x;
 
-    x = ((mem->logicalMemory[REG_NR14] & 0x7) << 8) | mem->logicalMemory[REG_NR13];
+    x = ((mem->ioRegisters[REG_NR14 - OFFSET_IOREGISTERS] & 0x7) << 8) | mem->ioRegisters[REG_NR13 - OFFSET_IOREGISTERS];
     audio->channels[0].frequency = 131072.0 / (2048.0 - x);
     if (audio->channels[0].frequency < 100.0) audio->channels[0].frequency = 0.0;
 
-    x = ((mem->logicalMemory[REG_NR24] & 0x7) << 8) | mem->logicalMemory[REG_NR23];
+    x = ((mem->ioRegisters[REG_NR24 - OFFSET_IOREGISTERS] & 0x7) << 8) | mem->ioRegisters[REG_NR23 - OFFSET_IOREGISTERS];
     audio->channels[1].frequency = 131072.0 / (2048.0 - x);
     if (audio->channels[1].frequency < 100.0) audio->channels[1].frequency = 0.0;
 
-    x = ((mem->logicalMemory[REG_NR34] & 0x7) << 8) | mem->logicalMemory[REG_NR33];
-    audio->channels[2].frequency = getBit(mem->logicalMemory[REG_NR30], 7) ? (65536.0 / (2048.0 - x)) : 0.0;
+    x = ((mem->ioRegisters[REG_NR34 - OFFSET_IOREGISTERS] & 0x7) << 8) | mem->ioRegisters[REG_NR33 - OFFSET_IOREGISTERS];
+    audio->channels[2].frequency = getBit(mem->ioRegisters[REG_NR30 - OFFSET_IOREGISTERS], 7) ? (65536.0 / (2048.0 - x)) : 0.0;
     if (audio->channels[0].frequency < 100.0) audio->channels[0].frequency = 0.0;
 }
 
+static void writeFrequencyRegister(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    mem->ioRegisters[address - OFFSET_IOREGISTERS] = value;
+    updateFrequencies(context, mem);
+}
+
 void audioCallback(void *user_data, uint8_t *raw_buffer, int bytes) {
     Audio* audio = user_data;
     int16_t* snd = (int16_t*) raw_buffer;
@@ -19,8 +19,8 @@ struct Audio {
     AudioChannel channels[4];
 };
 
-void AUD_init(Audio* audio, int sampleRate);
+void AUD_init(Audio* audio, Memory* mem, int sampleRate);
+void AUD_reset(Audio* audio, Memory* mem);
 void AUD_destroy(Audio* audio);
-void AUD_update(Audio* audio, Memory* mem);
 
 #endif
\ No newline at end of file
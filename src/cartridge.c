@@ -7,30 +7,7 @@
 #include "cartridge.h"
 #include "memory.h"
 
-void CART_init(Cartridge* cart, Memory* mem) {
-    // Set header data
-    memcpy(cart->title, mem->romBanks + 0x0134, 16);
-    cart->title[16] = '\0';
-    cart->type = mem->romBanks[0x0147];
-    cart->romSize = mem->romBanks[0x0148];
-    cart->ramSize = mem->romBanks[0x0149];
-
-    // Set default register values (usually 0)
-    cart->RAMG = 0;
-    cart->BANK1 = 1;
-    cart->BANK2 = 0;
-    cart->MODE = 0;
-    cart->ROMB = 0;
-    cart->ROMB0 = 0;
-    cart->ROMB1 = 0;
-    cart->RAMB = 0;
-}
-
-void CART_destroy(Cartridge* cart) {
-    free(cart);
-    cart = NULL;
-}
-
+static void ROM_ONLY(Memory* mem, uint16_t address, uint8_t value);
 static void MBC1(Memory* mem, uint16_t address, uint8_t value);
 static void MBC1_RAM(Memory* mem, uint16_t address, uint8_t value);
 static void MBC1_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value);
@@ -56,8 +33,8 @@ static void MBC6(Memory* mem, uint16_t address, uint8_t value);
 static void MBC7_SENSOR_RUMBLE_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value);
 static void unimplemented(uint8_t mbcCode);
 
-void (*MBC_MAP[])(Memory*, uint16_t, uint8_t) = {
-    NULL,
+static void (*const MBC_MAP[])(Memory*, uint16_t, uint8_t) = {
+    ROM_ONLY,
     MBC1,
     MBC1_RAM,
     MBC1_RAM_BATTERY,
@@ -94,14 +71,65 @@ void (*MBC_MAP[])(Memory*, uint16_t, uint8_t) = {
     MBC7_SENSOR_RUMBLE_RAM_BATTERY
 };
 
-void CART_mbcDispatch(Memory* mem, uint16_t address, uint8_t value) {
-    uint8_t mbcCode = MEM_getByte(mem, 0x0147);
-    void (*mbcFunction)(Memory*, uint16_t, uint8_t) = MBC_MAP[mbcCode];
-    if (mbcFunction == NULL) {
-        printf("Undefined MBC: 0x%x\n", mbcCode);
-    } else {
-        mbcFunction(mem, address, value);
+void CART_init(Cartridge* cart, Memory* mem) {
+    // Set header data
+    memcpy(cart->title, mem->romBanks + 0x0134, 16);
+    cart->title[16] = '\0';
+    cart->type = mem->romBanks[0x0147];
+    cart->romSize = mem->romBanks[0x0148];
+    cart->ramSize = mem->romBanks[0x0149];
+    cart->headerChecksum = mem->romBanks[0x014D];
+    cart->globalChecksum = (mem->romBanks[0x014E] << 8) | mem->romBanks[0x014F];
+
+    CART_reset(cart);
+
+    // Resolve the MBC write handler
+    cart->mbcWrite = cart->type < sizeof(MBC_MAP) / sizeof(MBC_MAP[0])
+        ? MBC_MAP[cart->type]
+        : NULL;
+    if (cart->mbcWrite == NULL) {
+        fprintf(stderr, "Unsupported MBC: 0x%x\n", cart->type);
+        exit(1);
+    }
+}
+
+// Set the MBC registers to their power-on values (usually 0)
+void CART_reset(Cartridge* cart) {
+    cart->RAMG = 0;
+    cart->BANK1 = 1;
+    cart->BANK2 = 0;
+    cart->MODE = 0;
+    cart->ROMB = 0;
+    cart->ROMB0 = 0;
+    cart->ROMB1 = 0;
+    cart->RAMB = 0;
+}
+
+// Cartridge types with battery-backed RAM
+bool CART_hasBattery(const Cartridge* cart) {
+    return cart->type != 0 && strchr((const char []){0x03, 0x06, 0x09, 0x0D, 0x0F, 0x10, 0x13, 0x1B, 0x1E, 0x22, '\0'}, cart->type) != NULL;
+}
+
+// Checksum the boot ROM verifies before starting the cartridge
+uint8_t CART_computeHeaderChecksum(const uint8_t* rom) {
+    uint8_t checksum = 0;
+    for (int i = 0x0134; i <= 0x014C; ++i) {
+        checksum = checksum - rom[i] - 1;
+    }
+    return checksum;
+}
+
+// Sum of every byte but the global checksum itself (not verified by hardware)
+uint16_t CART_computeGlobalChecksum(const uint8_t* rom, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+        sum += rom[i];
     }
+    return (sum - rom[0x014E] - rom[0x014F]) & 0xFFFF;
+}
+
+static void ROM_ONLY(Memory* mem, uint16_t address, uint8_t value) {
+    // No MBC - writes to the ROM area are ignored
 }
 
 static void MBC1(Memory* mem, uint16_t address, uint8_t value) {
@@ -109,7 +137,7 @@ static void MBC1(Memory* mem, uint16_t address, uint8_t value) {
 
     if (address <= 0x1FFF) {
         cart->RAMG = value & 0xF;
-        mem->extRamEnabled = (cart->RAMG == 0xA);
+        MEM_setRamEnabled(mem, cart->RAMG == 0xA);
 
     } else if (address <= 0x3FFF) {
         cart->BANK1 = value & 0x1F;
@@ -143,31 +171,31 @@ static void MBC1_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
 }
 
 static void MBC2(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC2
+    unimplemented(mem->cartridge->type); // TODO: MBC2
 }
 
 static void MBC2_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC2_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: MBC2_BATTERY
 }
 
 static void ROM_RAM(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: ROM_RAM
+    unimplemented(mem->cartridge->type); // TODO: ROM_RAM
 }
 
 static void ROM_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: ROM_RAM_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: ROM_RAM_BATTERY
 }
 
 static void MMM01(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MMM01
+    unimplemented(mem->cartridge->type); // TODO: MMM01
 }
 
 static void MMM01_RAM(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MMM01_RAM
+    unimplemented(mem->cartridge->type); // TODO: MMM01_RAM
 }
 
 static void MMM01_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MMM01_RAM_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: MMM01_RAM_BATTERY
 }
 
 static void MBC3_TIMER_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
@@ -179,12 +207,12 @@ static void MBC3_TIMER_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value)
 }
 
 static void MBC3(Memory* mem, uint16_t address, uint8_t value) {
-    //unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC3
+    //unimplemented(mem->cartridge->type); // TODO: MBC3
     Cartridge* cart = mem->cartridge;
 
     if (address <= 0x1FFF) {
         cart->RAMG = value & 0xF;
-        mem->extRamEnabled = (cart->RAMG == 0xA);
+        MEM_setRamEnabled(mem, cart->RAMG == 0xA);
 
     } else if (address <= 0x3FFF) {
         cart->ROMB = value & 0x7F;
@@ -205,35 +233,35 @@ static void MBC3_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
 }
 
 static void MBC5(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5
+    unimplemented(mem->cartridge->type); // TODO: MBC5
 }
 
 static void MBC5_RAM(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5_RAM
+    unimplemented(mem->cartridge->type); // TODO: MBC5_RAM
 }
 
 static void MBC5_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5_RAM_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: MBC5_RAM_BATTERY
 }
 
 static void MBC5_RUMBLE(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5_RUMBLE
+    unimplemented(mem->cartridge->type); // TODO: MBC5_RUMBLE
 }
 
 static void MBC5_RUMBLE_RAM(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5_RUMBLE_RAM
+    unimplemented(mem->cartridge->type); // TODO: MBC5_RUMBLE_RAM
 }
 
 static void MBC5_RUMBLE_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC5_RUMBLE_RAM_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: MBC5_RUMBLE_RAM_BATTERY
 }
 
 static void MBC6(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC6
+    unimplemented(mem->cartridge->type); // TODO: MBC6
 }
 
 static void MBC7_SENSOR_RUMBLE_RAM_BATTERY(Memory* mem, uint16_t address, uint8_t value) {
-    unimplemented(MEM_getByte(mem, 0x0147)); // TODO: MBC7_SENSOR_RUMBLE_RAM_BATTERY
+    unimplemented(mem->cartridge->type); // TODO: MBC7_SENSOR_RUMBLE_RAM_BATTERY
 }
 
 static void unimplemented(uint8_t mbcCode) {
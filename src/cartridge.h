@@ -2,9 +2,11 @@
 #define CARTRIDGE_H
 
 typedef struct Cartridge Cartridge;
+typedef struct Memory Memory;
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
-#include "memory.h"
 
 struct Cartridge {
     // Header data
@@ -12,6 +14,8 @@ struct Cartridge {
     uint8_t type;
     uint8_t romSize;
     uint8_t ramSize;
+    uint8_t headerChecksum;  // 0x014D, over 0x0134-0x014C
+    uint16_t globalChecksum; // 0x014E-0x014F (big endian), over the whole ROM except itself
 
     // MBC registers (named according to GBCTR)
     uint8_t RAMG;
@@ -22,10 +26,15 @@ struct Cartridge {
     uint8_t ROMB0;
     uint8_t ROMB1;
     uint8_t RAMB;
+
+    // MBC register write handler, resolved from the cartridge type when the ROM is loaded
+    void (*mbcWrite)(Memory* mem, uint16_t address, uint8_t value);
 };
 
 void CART_init(Cartridge* cart, Memory* mem);
-void CART_destroy(Cartridge* cart);
-void CART_mbcDispatch(Memory* mem, uint16_t address, uint8_t value);
+void CART_reset(Cartridge* cart);
+bool CART_hasBattery(const Cartridge* cart);
+uint8_t CART_computeHeaderChecksum(const uint8_t* rom);
+uint16_t CART_computeGlobalChecksum(const uint8_t* rom, size_t size);
 
 #endif
\ No newline at end of file
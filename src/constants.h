@@ -6,6 +6,15 @@
 #define GB_SCREEN_WIDTH  160
 #define GB_SCREEN_HEIGHT 144
 
+// Machine cycles per frame (154 lines of 114 cycles)
+#define GB_FRAME_CYCLES 17556
+
+// How often battery RAM is flushed to the save file, in machine cycles (about 1 second)
+#define SAVE_SYNC_INTERVAL 1048576
+
+// Maximum number of file writes waiting for the I/O thread
+#define IO_QUEUE_CAPACITY 16
+
 // Jump conditions
 #define PARAM_CC_NZ 100
 #define PARAM_CC_Z  101
@@ -58,6 +67,7 @@
 #define OFFSET_ROMBANK0 0x0000
 #define OFFSET_ROMBANKN 0x4000
 #define OFFSET_VIDEORAM 0x8000
+#define OFFSET_TILEMAPS 0x9800
 #define OFFSET_EXTRAM   0xA000
 #define OFFSET_WORKRAMBANK0 0xC000
 #define OFFSET_WORKRAMBANK1 0xD000
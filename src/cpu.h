@@ -56,6 +56,9 @@ struct CPU {
 
     // Interrupt Master Enable flag
     int IME;
+
+    // Machine cycles left until the current instruction is done
+    int mCycleTimer;
 };
 
 // Flag getters
@@ -71,7 +74,6 @@ void CPU_setFlagH(CPU* cpu, int value);
 void CPU_setFlagC(CPU* cpu, int value);
 
 void CPU_init(CPU* cpu);
-void CPU_destroy(CPU* cpu);
 int CPU_emulateCycle(CPU* cpu, GPU* gpu, Memory* mem, Timer* timer, Joypad* joy);
 
 #endif
\ No newline at end of file
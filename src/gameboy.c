@@ -0,0 +1,143 @@
+#include <stdlib.h>
+
+#include "gameboy.h"
+
+static GameBoy* allocateInstance(int flags);
+static void retainSnapshot(GB_Snapshot* snapshot);
+
+// Create an instance. With GB_LOCAL_HUGE_PAGES, call this from the thread that is going to run it.
+GameBoy* GB_create(const char* romPath, SaveMode saveMode, IOWorker* io, int flags) {
+    GameBoy* gb = allocateInstance(flags); // freed in GB_destroy
+
+    MEM_init(gb->mem);
+    MEM_loadROM(gb->mem, romPath, saveMode, io);
+    MEM_placeExtRam(gb->mem, REGION_alloc(&(gb->region), MEM_getPlainExtRamSize(gb->mem), 64));
+
+    CPU_init(gb->cpu);
+    gb->mem->watchPc = &(gb->cpu->PC);
+    GPU_init(gb->gpu, gb->mem);
+    TIMER_init(gb->timer, gb->mem);
+    JOY_init(gb->joy, gb->mem);
+
+    gb->audio = NULL;
+    gb->snapshot = NULL;
+    return gb;
+}
+
+// Destroy the instance (battery RAM is written out by MEM_release). Audio belongs to whoever attached it.
+void GB_destroy(GameBoy* gb) {
+    GB_Snapshot* snapshot = gb->snapshot;
+    Region region = gb->region; // the instance lives in its own region
+    MEM_release(gb->mem);
+    REGION_destroy(&region);
+    if (snapshot != NULL) {
+        GB_releaseSnapshot(snapshot);
+    }
+}
+
+// Power cycle the instance in place: everything is back to its power-on state except battery RAM. Nothing is freed
+// and the ROM is not read again, so this is much cheaper than destroying and creating an instance.
+void GB_reset(GameBoy* gb) {
+    MEM_reset(gb->mem);
+    CPU_init(gb->cpu);
+    GPU_init(gb->gpu, gb->mem);
+    TIMER_init(gb->timer, gb->mem);
+    JOY_init(gb->joy, gb->mem);
+    if (gb->audio != NULL) {
+        AUD_reset(gb->audio, gb->mem);
+    }
+}
+
+// Run one machine cycle, 0 if the CPU stopped
+int GB_emulateCycle(GameBoy* gb) {
+    if (!CPU_emulateCycle(gb->cpu, gb->gpu, gb->mem, gb->timer, gb->joy)) {
+        return 0;
+    }
+    GPU_update(gb->cpu, gb->gpu, gb->mem);
+    TIMER_update(gb->cpu, gb->mem, gb->timer);
+    return 1;
+}
+
+// Freeze the current state of an instance. The caller holds the first reference (see GB_releaseSnapshot).
+GB_Snapshot* GB_snapshot(GameBoy* gb) {
+    GB_Snapshot* snapshot = malloc(sizeof(*snapshot)); // freed in GB_releaseSnapshot
+    snapshot->cpu = *gb->cpu;
+    snapshot->gpu = *gb->gpu;
+    snapshot->timer = *gb->timer;
+    snapshot->joy = *gb->joy;
+
+    snapshot->mem = aligned_alloc(_Alignof(Memory), sizeof(*snapshot->mem)); // freed in GB_releaseSnapshot
+    MEM_snapshot(snapshot->mem, gb->mem);
+
+    snapshot->hookGpu = gb->gpu;
+    snapshot->hookTimer = gb->timer;
+    snapshot->hookJoy = gb->joy;
+    snapshot->hookAudio = gb->audio;
+    snapshot->flags = gb->flags;
+
+    snapshot->refCount = 1;
+    pthread_mutex_init(&(snapshot->lock), NULL);
+    return snapshot;
+}
+
+// Start a new instance from a snapshot. Forking is cheap (no RAM is copied up front) and forks of the same snapshot
+// can run on different threads. Forks have no audio and never write save files.
+GameBoy* GB_fork(GB_Snapshot* snapshot) {
+    GameBoy* child = allocateInstance(snapshot->flags); // freed in GB_destroy
+    *child->cpu = snapshot->cpu;
+    *child->gpu = snapshot->gpu;
+    *child->timer = snapshot->timer;
+    *child->joy = snapshot->joy;
+
+    MEM_fork(child->mem, snapshot->mem, REGION_alloc(&(child->region), MEM_getPlainExtRamSize(snapshot->mem), 64));
+    MEM_retargetIoHooks(child->mem, snapshot->hookGpu, child->gpu);
+    MEM_retargetIoHooks(child->mem, snapshot->hookTimer, child->timer);
+    MEM_retargetIoHooks(child->mem, snapshot->hookJoy, child->joy);
+    MEM_retargetIoHooks(child->mem, snapshot->hookAudio, NULL);
+    child->mem->watchPc = &(child->cpu->PC);
+
+    child->audio = NULL;
+    retainSnapshot(snapshot);
+    child->snapshot = snapshot;
+    return child;
+}
+
+// Drop a reference to a snapshot, freeing it once neither its creator nor any fork uses it
+void GB_releaseSnapshot(GB_Snapshot* snapshot) {
+    pthread_mutex_lock(&(snapshot->lock));
+    int refCount = --(snapshot->refCount);
+    pthread_mutex_unlock(&(snapshot->lock));
+    if (refCount > 0) return;
+
+    MEM_destroy(snapshot->mem);
+    pthread_mutex_destroy(&(snapshot->lock));
+    free(snapshot);
+}
+
+// Set up the region holding the instance and carve the instance and its components out of it. Room is reserved for
+// the largest external RAM a cartridge can have, since its size is only known once the ROM is loaded.
+static GameBoy* allocateInstance(int flags) {
+    size_t size = sizeof(GameBoy) + sizeof(Memory) + sizeof(CPU) + sizeof(GPU) + sizeof(Timer) + sizeof(Joypad)
+        + (MEM_MAX_EXTRAM_BANKS * 0x2000) + (7 * 64);
+    Region region;
+    if (!REGION_init(&region, size, flags & GB_LOCAL_HUGE_PAGES)) {
+        exit(1);
+    }
+
+    GameBoy* gb = REGION_alloc(&region, sizeof(*gb), 64);
+    gb->region = region;
+    gb->flags = flags;
+
+    gb->mem = REGION_alloc(&(gb->region), sizeof(*gb->mem), _Alignof(Memory));
+    gb->cpu = REGION_alloc(&(gb->region), sizeof(*gb->cpu), 64);
+    gb->gpu = REGION_alloc(&(gb->region), sizeof(*gb->gpu), 64);
+    gb->timer = REGION_alloc(&(gb->region), sizeof(*gb->timer), 64);
+    gb->joy = REGION_alloc(&(gb->region), sizeof(*gb->joy), 64);
+    return gb;
+}
+
+static void retainSnapshot(GB_Snapshot* snapshot) {
+    pthread_mutex_lock(&(snapshot->lock));
+    ++(snapshot->refCount);
+    pthread_mutex_unlock(&(snapshot->lock));
+}
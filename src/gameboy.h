@@ -0,0 +1,66 @@
+#ifndef GAMEBOY_H
+#define GAMEBOY_H
+
+typedef struct GameBoy GameBoy;
+typedef struct GB_Snapshot GB_Snapshot;
+
+#include <pthread.h>
+
+#include "audio.h"
+#include "cpu.h"
+#include "gpu.h"
+#include "io.h"
+#include "joypad.h"
+#include "memory.h"
+#include "region.h"
+#include "save.h"
+#include "timer.h"
+
+typedef enum GB_Flags {
+    GB_LOCAL_HUGE_PAGES = 0x1 // keep the instance on transparent huge pages on the NUMA node of the creating thread
+} GB_Flags;
+
+// One emulated Game Boy: the instance and the components that make up its state, all allocated from one region
+struct GameBoy {
+    CPU* cpu;
+    GPU* gpu;
+    Memory* mem;
+    Timer* timer;
+    Joypad* joy;
+    Audio* audio;          // NULL unless attached by the frontend (forks never have audio)
+    GB_Snapshot* snapshot; // snapshot the instance was forked from, NULL otherwise
+
+    Region region;
+    int flags; // GB_Flags
+};
+
+// Frozen state of an instance that any number of forks can start from. Forks share its RAM pages copy-on-write,
+// so it is reference counted and stays alive until the last fork is destroyed.
+struct GB_Snapshot {
+    CPU cpu;
+    GPU gpu;
+    Timer timer;
+    Joypad joy;
+    Memory* mem;
+
+    // Components of the instance the snapshot was taken from, which the I/O hooks in mem still point to
+    const void* hookGpu;
+    const void* hookTimer;
+    const void* hookJoy;
+    const void* hookAudio;
+
+    int flags; // GB_Flags of the instance, passed on to forks
+
+    int refCount;
+    pthread_mutex_t lock;
+};
+
+GameBoy* GB_create(const char* romPath, SaveMode saveMode, IOWorker* io, int flags);
+void GB_destroy(GameBoy* gb);
+void GB_reset(GameBoy* gb);
+int GB_emulateCycle(GameBoy* gb);
+GB_Snapshot* GB_snapshot(GameBoy* gb);
+GameBoy* GB_fork(GB_Snapshot* snapshot);
+void GB_releaseSnapshot(GB_Snapshot* snapshot);
+
+#endif
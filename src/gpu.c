@@ -1,5 +1,5 @@
+#include <pthread.h>
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include "common/bitwise.h"
@@ -8,13 +8,43 @@
 #include "gpu.h"
 #include "memory.h"
 
-void GPU_init(GPU* gpu) {
-    gpu->framebuffer = malloc(sizeof(uint8_t) * GB_SCREEN_WIDTH * GB_SCREEN_HEIGHT * 4 + 512); // freed in main.c:quit
+#if defined(__x86_64__) && defined(__GNUC__)
+    #include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+static const uint8_t* getTile(GPU* gpu, Memory* mem, int tile);
+static void decodeTileScalar(uint8_t* pixels, const uint8_t* data);
+static void applyPaletteScalar(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count);
+#if defined(__x86_64__) && defined(__GNUC__)
+static void decodeTileSse2(uint8_t* pixels, const uint8_t* data);
+static void applyPaletteSsse3(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count);
+static void applyPaletteAvx2(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+static void decodeTileNeon(uint8_t* pixels, const uint8_t* data);
+static void applyPaletteNeon(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count);
+#endif
+static void selectKernels(void);
+static void scanOam(GPU* gpu, Memory* mem, int line);
+static void updatePalette(GPU* gpu, Memory* mem, uint16_t address);
+static void writePalette(void* context, Memory* mem, uint16_t address, uint8_t value);
+static void compareLyc(Memory* mem);
+static void writeStat(void* context, Memory* mem, uint16_t address, uint8_t value);
+static void writeLyc(void* context, Memory* mem, uint16_t address, uint8_t value);
+
+// Tile decoder and palette kernel for this CPU, picked once by the first GPU_init (the scalar ones are the reference)
+static void (*decodeTile)(uint8_t* pixels, const uint8_t* data) = decodeTileScalar;
+static void (*applyPalette)(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count) = applyPaletteScalar;
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+
+void GPU_init(GPU* gpu, Memory* mem) {
+    pthread_once(&kernelsOnce, selectKernels);
+
     gpu->fbUpdated = false;
     gpu->machineCycleCounter = 0;
-
-    gpu->backgroundMap = malloc(32 * 32 * 16);
-    gpu->windowMap = malloc(32 * 32 * 16);
+    gpu->windowLine = 0;
+    gpu->lineSpritesNo = 0;
 
     // White - #9BBC0F
     gpu->colorPalette[0][0] = 0x9B;
@@ -32,174 +62,272 @@ void GPU_init(GPU* gpu) {
     gpu->colorPalette[3][0] = 0x0F;
     gpu->colorPalette[3][1] = 0x38;
     gpu->colorPalette[3][2] = 0x0F;
+    for (int i = 0; i < 4; ++i) {
+        gpu->colorPalette[i][3] = 0xFF;
+    }
+
+    MEM_setIoHook(mem, REG_STAT, NULL, writeStat, gpu);
+    MEM_setIoHook(mem, REG_LYC, NULL, writeLyc, gpu);
+    compareLyc(mem);
+
+    for (uint16_t address = REG_BGP; address <= REG_OBP1; ++address) {
+        MEM_setIoHook(mem, address, NULL, writePalette, gpu);
+        updatePalette(gpu, mem, address);
+    }
 }
 
-void GPU_destroy(GPU* gpu) {
-    free(gpu->backgroundMap);
-    gpu->backgroundMap = NULL;
-    free(gpu->framebuffer);
-    gpu->framebuffer = NULL;
-    free(gpu);
-    gpu = NULL;
+// Rebuild the lookup table of a palette register (BGP, OBP0 or OBP1)
+static void updatePalette(GPU* gpu, Memory* mem, uint16_t address) {
+    uint8_t value = mem->ioRegisters[address - OFFSET_IOREGISTERS];
+    for (int color = 0; color < 4; ++color) {
+        memcpy(&(gpu->palettes[address - REG_BGP][color]), gpu->colorPalette[(value >> (color * 2)) & 0x3], 4);
+    }
 }
 
-static int getColorNumber(Memory* mem, int index, uint16_t paletteAddress) {
-    return (mem->logicalMemory[paletteAddress] & (0x3 << (index * 2))) >> (index * 2);
+static void writePalette(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    mem->ioRegisters[address - OFFSET_IOREGISTERS] = value;
+    updatePalette(context, mem, address);
 }
 
-static void updateBackgroundMap(GPU* gpu, Memory* mem) {
-    uint8_t LCDC = mem->logicalMemory[REG_LCDC];
-    uint8_t SCY = mem->logicalMemory[REG_SCY];
-    uint8_t LY = mem->logicalMemory[REG_LY];
-    int mapY = (SCY + LY) / 8;
-    if (mapY >= 32) mapY -= 32;
-
-    for (int mapX = 0; mapX < 32; ++mapX) {
-        uint16_t address = (getBit(LCDC, 3) ? 0x9C00 : 0x9800) + (mapY * 0x20) + mapX;
-        uint16_t tileAddress = getBit(LCDC, 4)
-            ? 0x8000 + (mem->logicalMemory[address] * 0x10)
-            : 0x9000 + (((int8_t) (mem->logicalMemory[address])) * 0x10);
-
-        uint8_t* srcAddress = mem->videoRam + tileAddress - OFFSET_VIDEORAM;
-        uint8_t* targetAddress = gpu->backgroundMap + (mapY * 16 * 32) + (mapX * 16);
-        memcpy(targetAddress, srcAddress, 16);
+// Decoded pixels of a tile (numbered from 0x8000), decoding it first if VRAM changed since it was last drawn
+static const uint8_t* getTile(GPU* gpu, Memory* mem, int tile) {
+    uint8_t* pixels = gpu->tileCache[tile];
+    if (MEM_isTileDirty(mem, tile)) {
+        decodeTile(pixels, mem->videoRam + (tile * 16));
+        MEM_clearTileDirty(mem, tile);
     }
+    return pixels;
 }
 
-static void renderBgScanline(GPU* gpu, Memory* mem, int line) {
-    if (line >= GB_SCREEN_HEIGHT) return; // VBlank period
-    uint8_t SCX = mem->logicalMemory[REG_SCX];
-    uint8_t SCY = mem->logicalMemory[REG_SCY];
+// Turn the 16 bytes of a tile (two bit planes per row) into 64 color numbers
+static void decodeTileScalar(uint8_t* pixels, const uint8_t* data) {
+    for (int row = 0; row < 8; ++row) {
+        uint8_t byte1 = data[row * 2];
+        uint8_t byte2 = data[(row * 2) + 1];
+        for (int i = 0; i < 8; ++i) {
+            pixels[(row * 8) + i] = getBit(byte2, 7 - i) << 1 | getBit(byte1, 7 - i);
+        }
+    }
+}
 
-    int tileXOffset = SCX / 8, tileYOffset = (SCY + line) / 8;
-    int pixelXOffset = SCX % 8, pixelYOffset = (SCY + line) % 8;
-    if (tileYOffset >= 32) tileYOffset -= 32;
+// Write the RGBA pixels of count color numbers
+static void applyPaletteScalar(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count) {
+    for (int i = 0; i < count; ++i) {
+        memcpy(target + (i * 4), &(palette[colors[i]]), 4);
+    }
+}
 
-    uint8_t* linePtr = gpu->framebuffer + (line * GB_SCREEN_WIDTH * 4);
-    uint8_t* lineEndPtr = linePtr + (GB_SCREEN_WIDTH * 4);
-
-    uint8_t* mapStartPtr = gpu->backgroundMap + (tileYOffset * 16 * 32);
-    uint8_t* mapPtr = mapStartPtr + (tileXOffset * 16);
-
-    // Draw the first few pixels separately
-    uint8_t* firstChunk = mapPtr + (pixelYOffset * 2);
-    uint8_t byte1 = firstChunk[0];
-    uint8_t byte2 = firstChunk[1];
-    for (int i = pixelXOffset; i < 8; ++i) {
-        int color = getBit(byte2, 7 - i) << 1 | getBit(byte1, 7 - i);
-        memcpy(linePtr + ((i - pixelXOffset) * 4), &(gpu->colorPalette[getColorNumber(mem, color, REG_BGP)]), 3);
-        linePtr[((i - pixelXOffset) * 4) + 3] = 0xFF;
+// The vector tile decoders test every bit of a row at once, two rows per register: lane i of a row holds both plane
+// bytes masked with the bit of pixel i. The vector palette kernels use the 16-byte palette as a byte shuffle table,
+// pixel i of a register picking bytes 4 * color + 0..3; they leave the last count % width pixels to the scalar one.
+#if defined(__x86_64__) && defined(__GNUC__)
+static void decodeTileSse2(uint8_t* pixels, const uint8_t* data) {
+    const __m128i bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    for (int row = 0; row < 8; row += 2) {
+        __m128i low = _mm_set_epi64x(data[(row * 2) + 2] * UINT64_C(0x0101010101010101), data[row * 2] * UINT64_C(0x0101010101010101));
+        __m128i high = _mm_set_epi64x(data[(row * 2) + 3] * UINT64_C(0x0101010101010101), data[(row * 2) + 1] * UINT64_C(0x0101010101010101));
+        low = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(low, bits), bits), _mm_set1_epi8(1));
+        high = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(high, bits), bits), _mm_set1_epi8(2));
+        _mm_storeu_si128((__m128i*) (pixels + (row * 8)), _mm_or_si128(low, high));
     }
-    linePtr += ((8 - pixelXOffset) * 4);
+}
 
-    // Draw the remaining pixels
-    for (int tileNo = tileXOffset + 1; linePtr < lineEndPtr; ++tileNo) {
-        if (tileNo == 32) tileNo = 0;
-        uint8_t* chunk = mapStartPtr + (tileNo * 16) + (pixelYOffset * 2);
-        for (int i = 0; i < 8; ++i) {
-            int color = getBit(chunk[1], 7 - i) << 1 | getBit(chunk[0], 7 - i);
-            memcpy(linePtr + ((i) * 4), &(gpu->colorPalette[getColorNumber(mem, color, REG_BGP)]), 3);
-            linePtr[((i) * 4) + 3] = 0xFF;
-        }
-        linePtr += (8 * 4);
+__attribute__((target("ssse3")))
+static void applyPaletteSsse3(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count) {
+    const __m128i table = _mm_loadu_si128((const __m128i*) palette);
+    const __m128i spread = _mm_set_epi8(3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+    const __m128i bytes = _mm_set_epi8(3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0);
+    for (; count >= 4; colors += 4, target += 16, count -= 4) {
+        uint32_t four;
+        memcpy(&four, colors, sizeof(four));
+        __m128i index = _mm_shuffle_epi8(_mm_cvtsi32_si128(four), spread);
+        index = _mm_add_epi8(_mm_add_epi8(index, index), _mm_add_epi8(index, index));
+        index = _mm_add_epi8(index, bytes);
+        _mm_storeu_si128((__m128i*) target, _mm_shuffle_epi8(table, index));
     }
+    applyPaletteScalar(target, colors, palette, count);
 }
 
-static void renderWindow(GPU* gpu, Memory* mem) {
-    uint8_t* internalFramebuffer = malloc(256 * 256); // freed at the end of this function
-    uint8_t WX = mem->logicalMemory[REG_WX];
-    uint8_t WY = mem->logicalMemory[REG_WY];
-    uint8_t LCDC = mem->logicalMemory[REG_LCDC];
-
-    for (int mapY = 0; mapY < 32; ++mapY) {
-        for (int mapX = 0; mapX < 32; ++mapX) {
-            uint16_t address = (getBit(LCDC, 6) ? 0x9C00 : 0x9800) + (mapY * 0x20) + mapX;
-            uint16_t tileAddress = getBit(LCDC, 4)
-                ? 0x8000 + (mem->logicalMemory[address] * 0x10)
-                : 0x9000 + (((int8_t) (mem->logicalMemory[address])) * 0x10);
-
-            for (int i = 0; i < 16; i += 2) {
-                uint8_t byte1 = mem->logicalMemory[tileAddress + i];
-                uint8_t byte2 = mem->logicalMemory[tileAddress + i + 1];
-                
-                int offset = (mapY * 8 * 256) + (((int)(i / 2)) * 256) + (mapX * 8);
-                for (int i = 0; i < 8; ++i) {
-                    internalFramebuffer[offset + i] = getBit(byte2, 7 - i) << 1 | getBit(byte1, 7 - i);
-                }
-            }
-        }
+// Eight pixels per register: both lanes hold the palette and the same eight colors, each lane expands its own half
+__attribute__((target("avx2")))
+static void applyPaletteAvx2(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count) {
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) palette));
+    const __m256i spread = _mm256_set_epi8(7, 7, 7, 7, 6, 6, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4,
+                                           3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+    const __m256i bytes = _mm256_set_epi8(3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0,
+                                          3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0);
+    for (; count >= 8; colors += 8, target += 32, count -= 8) {
+        __m256i index = _mm256_broadcastsi128_si256(_mm_loadl_epi64((const __m128i*) colors));
+        index = _mm256_shuffle_epi8(index, spread);
+        index = _mm256_add_epi8(_mm256_slli_epi16(index, 2), bytes);
+        _mm256_storeu_si256((__m256i*) target, _mm256_shuffle_epi8(table, index));
+    }
+    applyPaletteScalar(target, colors, palette, count);
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+static void decodeTileNeon(uint8_t* pixels, const uint8_t* data) {
+    const uint8x16_t bits = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+    for (int row = 0; row < 8; row += 2) {
+        uint8x16_t low = vcombine_u8(vdup_n_u8(data[row * 2]), vdup_n_u8(data[(row * 2) + 2]));
+        uint8x16_t high = vcombine_u8(vdup_n_u8(data[(row * 2) + 1]), vdup_n_u8(data[(row * 2) + 3]));
+        low = vandq_u8(vtstq_u8(low, bits), vdupq_n_u8(1));
+        high = vandq_u8(vtstq_u8(high, bits), vdupq_n_u8(2));
+        vst1q_u8(pixels + (row * 8), vorrq_u8(low, high));
     }
+}
 
-    int xLowerBound = (WX - 7) < 0 ? 0 : (WX - 7);
-    for (int y = WY; y < 144; ++y) {
-        for (int x = xLowerBound; x < 160; ++x) {
-            int pos = (y * 160 * 4) + (x * 4);
-            int color = getColorNumber(mem, internalFramebuffer[((y - WY) * 256) + (x - WX + 7)], REG_BGP);
-            memcpy(gpu->framebuffer + pos, &(gpu->colorPalette[color]), 3);
-            gpu->framebuffer[pos + 3] = 0xFF;
-        }
+static void applyPaletteNeon(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count) {
+    const uint8x16_t table = vld1q_u8((const uint8_t*) palette);
+    const uint8x16_t spread = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+    const uint8x16_t bytes = {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3};
+    for (; count >= 4; colors += 4, target += 16, count -= 4) {
+        uint32_t four;
+        memcpy(&four, colors, sizeof(four));
+        uint8x16_t index = vqtbl1q_u8(vreinterpretq_u8_u32(vdupq_n_u32(four)), spread);
+        index = vaddq_u8(vshlq_n_u8(index, 2), bytes);
+        vst1q_u8(target, vqtbl1q_u8(table, index));
     }
+    applyPaletteScalar(target, colors, palette, count);
+}
+#endif
+
+// Point decodeTile and applyPalette at the fastest versions the CPU runs (SSE2 and NEON are part of their baseline)
+static void selectKernels(void) {
+    #if defined(__x86_64__) && defined(__GNUC__)
+    decodeTile = decodeTileSse2;
+    if (__builtin_cpu_supports("avx2")) {
+        applyPalette = applyPaletteAvx2;
+    } else if (__builtin_cpu_supports("ssse3")) {
+        applyPalette = applyPaletteSsse3;
+    }
+    #elif defined(__aarch64__) && defined(__ARM_NEON)
+    decodeTile = decodeTileNeon;
+    applyPalette = applyPaletteNeon;
+    #endif
+}
 
-    gpu->fbUpdated = true;
-    free(internalFramebuffer);
+// Tile a map entry points to, numbered from 0x8000
+static int getMapTile(Memory* mem, uint16_t mapAddress, int mapX, int mapY) {
+    uint8_t index = mem->videoRam[mapAddress + (mapY * 0x20) + mapX - OFFSET_VIDEORAM];
+    return getBit(mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS], 4) ? index : 256 + (int8_t) index;
+}
+
+// Draw the background pixels of a line, reading tile indices straight from the map for just the visible tiles
+static void renderBgScanline(GPU* gpu, Memory* mem, int line) {
+    if (line >= GB_SCREEN_HEIGHT) return; // VBlank period
+    uint8_t SCX = mem->ioRegisters[REG_SCX - OFFSET_IOREGISTERS];
+    uint8_t SCY = mem->ioRegisters[REG_SCY - OFFSET_IOREGISTERS];
+    uint16_t mapAddress = getBit(mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS], 3) ? 0x9C00 : 0x9800;
+
+    int mapY = ((SCY + line) / 8) % 32;
+    int tileRow = (SCY + line) % 8;
+    // Gather the color numbers of the visible tiles, then turn the whole line into pixels at once
+    uint8_t colors[GB_SCREEN_WIDTH + 8];
+    int tiles = ((SCX % 8) + GB_SCREEN_WIDTH + 7) / 8;
+    for (int i = 0; i < tiles; ++i) {
+        const uint8_t* tile = getTile(gpu, mem, getMapTile(mem, mapAddress, ((SCX / 8) + i) % 32, mapY));
+        memcpy(colors + (i * 8), tile + (tileRow * 8), 8);
+    }
+    memcpy(gpu->lineColors, colors + (SCX % 8), GB_SCREEN_WIDTH);
+    applyPalette(gpu->framebuffer + (line * GB_SCREEN_WIDTH * 4), colors + (SCX % 8), gpu->palettes[0], GB_SCREEN_WIDTH);
+}
+
+// Draw the window over the background of a line if it is enabled and covers the line. WX and WY are read as the line
+// is drawn, so mid-frame changes show up; the window line counter only advances on lines the window was drawn on.
+static void renderWindowScanline(GPU* gpu, Memory* mem, int line) {
+    uint8_t LCDC = mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS];
+    uint8_t WX = mem->ioRegisters[REG_WX - OFFSET_IOREGISTERS];
+    uint8_t WY = mem->ioRegisters[REG_WY - OFFSET_IOREGISTERS];
+    if (!getBit(LCDC, 0) || !getBit(LCDC, 5) || line < WY) return;
+
+    int xLowerBound = (WX - 7) < 0 ? 0 : (WX - 7);
+    if (xLowerBound >= GB_SCREEN_WIDTH) return;
+    int firstX = xLowerBound - WX + 7; // leftmost visible window column
+    int tiles = ((firstX % 8) + (GB_SCREEN_WIDTH - xLowerBound) + 7) / 8;
+
+    uint16_t mapAddress = getBit(LCDC, 6) ? 0x9C00 : 0x9800;
+    int windowY = gpu->windowLine++;
+    uint8_t colors[GB_SCREEN_WIDTH + 8];
+    for (int i = 0; i < tiles; ++i) {
+        const uint8_t* tile = getTile(gpu, mem, getMapTile(mem, mapAddress, (firstX / 8) + i, (windowY / 8) % 32));
+        memcpy(colors + (i * 8), tile + ((windowY % 8) * 8), 8);
+    }
+    memcpy(gpu->lineColors + xLowerBound, colors + (firstX % 8), GB_SCREEN_WIDTH - xLowerBound);
+    uint8_t* target = gpu->framebuffer + (line * GB_SCREEN_WIDTH * 4) + (xLowerBound * 4);
+    applyPalette(target, colors + (firstX % 8), gpu->palettes[0], GB_SCREEN_WIDTH - xLowerBound);
 }
 
 
-static void renderObjects(GPU* gpu, Memory* mem) {
-    for (int i = 0xFE00; i < 0xFE9F; i += 4) {
-        int yPos = mem->logicalMemory[i] - 16;
-        int xPos = mem->logicalMemory[i + 1] - 8;
-        if (xPos >= 160) continue;
+// Find the sprites on a line: the first GPU_LINE_SPRITES OAM entries that cover it, whether they are visible or not.
+// They are kept sorted by priority, which goes to the lowest X position and then to the lowest entry number.
+static void scanOam(GPU* gpu, Memory* mem, int line) {
+    int height = getBit(mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS], 2) ? 16 : 8;
+    gpu->lineSpritesNo = 0;
+    for (int entry = 0; entry < 40 && gpu->lineSpritesNo < GPU_LINE_SPRITES; ++entry) {
+        int yPos = mem->spriteAttributeTable[entry * 4] - 16;
+        if (line < yPos || line >= yPos + height) continue;
+
+        // Insert after every sprite with the same or a lower X position
+        uint8_t xPos = mem->spriteAttributeTable[(entry * 4) + 1];
+        int i = gpu->lineSpritesNo++;
+        for (; i > 0 && mem->spriteAttributeTable[(gpu->lineSprites[i - 1] * 4) + 1] > xPos; --i) {
+            gpu->lineSprites[i] = gpu->lineSprites[i - 1];
+        }
+        gpu->lineSprites[i] = entry;
+    }
+}
 
-        int tileIndex = mem->logicalMemory[i + 2];
-        uint16_t tileAddress = 0x8000 + (tileIndex * 0x10);
-        uint8_t flags = mem->logicalMemory[i + 3];
-        //int underBg = getBit(flags, 7);
+// Draw the sprites the OAM scan found for a line. Each pixel belongs to the highest priority sprite that is not
+// transparent there, which is then hidden if it is flagged to stay behind a non-zero background/window color.
+static void renderObjectsScanline(GPU* gpu, Memory* mem, int line) {
+    uint8_t LCDC = mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS];
+    if (!getBit(LCDC, 1)) return;
+
+    int height = getBit(LCDC, 2) ? 16 : 8;
+    bool taken[GB_SCREEN_WIDTH] = {false};
+    uint8_t* linePtr = gpu->framebuffer + (line * GB_SCREEN_WIDTH * 4);
+    for (int i = 0; i < gpu->lineSpritesNo; ++i) {
+        const uint8_t* attributes = mem->spriteAttributeTable + (gpu->lineSprites[i] * 4);
+        int yPos = attributes[0] - 16;
+        int xPos = attributes[1] - 8;
+        int tileIndex = height == 16 ? (attributes[2] & 0xFE) : attributes[2];
+        uint8_t flags = attributes[3];
+        int underBg = getBit(flags, 7);
         int yFlip = getBit(flags, 6);
         int xFlip = getBit(flags, 5);
-
-        //if (underBg) continue;
-
-        uint8_t longObjectMode = getBit(mem->logicalMemory[REG_LCDC], 2); // Is 8x16 mode active?
-        int rowIndex = yFlip ? (longObjectMode ? 31 : 15) : 0;
-        for (int i = 0; i < (longObjectMode ? 32 : 16); i += 2) {
-            uint8_t byte1 = mem->logicalMemory[tileAddress + i];
-            uint8_t byte2 = mem->logicalMemory[tileAddress + i + 1];
-
-            uint8_t pixels[8];
-            int pixelIndex = (xFlip ? 7 : 0);
-            for (int i = 0; i < 8; ++i) {
-                pixels[pixelIndex] = getBit(byte2, 7 - i) << 1 | getBit(byte1, 7 - i);
-                pixelIndex += (xFlip ? -1 : 1);
-            }
-
-            int offset = (yPos * 4 * 160) + ((rowIndex / 2) * 4 * 160) + (xPos * 4);
-            for (int i = 0; i < 8; ++i) {
-                if (pixels[i] == 0) continue;
-                int pos = offset + (i * 4);
-                if (pos < 0 || pos >= (160 * 144 * 4) || xPos + i < 0 || xPos + i >= 160) continue; // TODO: Removing the first check should work, but doesn't - possible bug
-                int color = getColorNumber(mem, pixels[i], (getBit(flags, 4) ? REG_OBP1 : REG_OBP0));
-                memcpy(gpu->framebuffer + pos, &(gpu->colorPalette[color]), 3);
-                gpu->framebuffer[pos + 3] = 0xFF;
-            }
-
-            rowIndex += (yFlip ? -2 : 2);
+        const uint32_t* palette = gpu->palettes[getBit(flags, 4) ? 2 : 1];
+
+        // The sprite may have moved since the scan, or 8x16 mode may have been switched off
+        int row = line - yPos;
+        if (row < 0 || row >= height) continue;
+        if (yFlip) row = height - 1 - row;
+        const uint8_t* pixels = getTile(gpu, mem, tileIndex + (row / 8)) + ((row % 8) * 8);
+
+        for (int j = 0; j < 8; ++j) {
+            int x = xPos + j;
+            if (x < 0 || x >= GB_SCREEN_WIDTH || taken[x]) continue;
+            uint8_t color = pixels[xFlip ? (7 - j) : j];
+            if (color == 0) continue;
+
+            taken[x] = true;
+            if (underBg && gpu->lineColors[x] != 0) continue;
+            memcpy(linePtr + (x * 4), &(palette[color]), 4);
         }
     }
 }
 
 // Update the GPU state (runs every machine cycle)
 void GPU_update(CPU* cpu, GPU* gpu, Memory* mem) {
-    uint8_t* IF = &(mem->logicalMemory[REG_IF]);
-    uint8_t* LYC = &(mem->logicalMemory[REG_LYC]);
-    uint8_t* LY = &(mem->logicalMemory[REG_LY]);
-    uint8_t* STAT = &(mem->logicalMemory[REG_STAT]);
+    uint8_t* IF = &(mem->ioRegisters[REG_IF - OFFSET_IOREGISTERS]);
+    uint8_t* LY = &(mem->ioRegisters[REG_LY - OFFSET_IOREGISTERS]);
+    uint8_t* STAT = &(mem->ioRegisters[REG_STAT - OFFSET_IOREGISTERS]);
 
     if (*LY < 144) {
         // Cycle through modes 2, 3, 0
         switch (gpu->machineCycleCounter) {
             case 0: // Mode 2
                 *STAT = (*STAT & 0xFC) | 2;
+                scanOam(gpu, mem, *LY);
                 break;
 
             case 19: // Mode 3
@@ -208,13 +336,15 @@ void GPU_update(CPU* cpu, GPU* gpu, Memory* mem) {
 
             case 61: // Mode 0 (HBlank)
                 *STAT = (*STAT & 0xFC) | 0;
-                updateBackgroundMap(gpu, mem);
                 renderBgScanline(gpu, mem, *LY);
+                renderWindowScanline(gpu, mem, *LY);
+                renderObjectsScanline(gpu, mem, *LY);
                 break;
 
             case 113: // Go to next line
                 ++*LY;
                 *STAT = (*STAT & 0xFC) | 2;
+                compareLyc(mem);
                 break;
 
             default:
@@ -228,28 +358,24 @@ void GPU_update(CPU* cpu, GPU* gpu, Memory* mem) {
             GPU_renderToFrameBuffer(gpu, mem);
             *IF |= 0x1;
             ++*LY;
+            compareLyc(mem);
         }
 
     } else if (*LY == 154) {
         // VBlank end
         if (gpu->machineCycleCounter == 113) {
             *LY = 0;
+            gpu->windowLine = 0;
+            compareLyc(mem);
         }
 
     } else {
         if (gpu->machineCycleCounter == 113) {
             ++*LY;
+            compareLyc(mem);
         }
     }
 
-    // Check for LYC=LY
-    if (*LYC == *LY) {
-        *STAT = setBit(*STAT, 2, 1);
-        *IF = setBit(*IF, 1, 1);
-    } else {
-        *STAT = setBit(*STAT, 2, 0);
-    }
-
     if (gpu->machineCycleCounter == 113) {
         gpu->machineCycleCounter = 0;
     } else {
@@ -257,23 +383,39 @@ void GPU_update(CPU* cpu, GPU* gpu, Memory* mem) {
     }
 }
 
+// Update the LY=LYC flag (runs whenever LY or LYC changes), requesting a STAT interrupt when it becomes set
+static void compareLyc(Memory* mem) {
+    uint8_t* STAT = &(mem->ioRegisters[REG_STAT - OFFSET_IOREGISTERS]);
+    int coincidence = mem->ioRegisters[REG_LY - OFFSET_IOREGISTERS] == mem->ioRegisters[REG_LYC - OFFSET_IOREGISTERS];
+    if (coincidence && !getBit(*STAT, 2) && getBit(*STAT, 6)) {
+        mem->ioRegisters[REG_IF - OFFSET_IOREGISTERS] |= 0x2;
+    }
+    *STAT = setBit(*STAT, 2, coincidence);
+}
+
+// The mode and coincidence bits of STAT are read-only
+static void writeStat(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    uint8_t* STAT = &(mem->ioRegisters[REG_STAT - OFFSET_IOREGISTERS]);
+    *STAT = (value & 0x78) | (*STAT & 0x07);
+}
+
+static void writeLyc(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    mem->ioRegisters[REG_LYC - OFFSET_IOREGISTERS] = value;
+    compareLyc(mem);
+}
+
 // Generate LCD framebuffer from VRAM
 void GPU_renderToFrameBuffer(GPU* gpu, Memory* mem) {
-    uint8_t LCDC = mem->logicalMemory[REG_LCDC];
+    uint8_t LCDC = mem->ioRegisters[REG_LCDC - OFFSET_IOREGISTERS];
     if (!getBit(LCDC, 7)) {
         // LCD disabled, return a blank screen
         for (int i = 0; i < (160 * 144 * 4); i += 4) {
-            memcpy(gpu->framebuffer + i, &(gpu->colorPalette[0]), 3);
-            gpu->framebuffer[i + 3] = 0xFF;
+            memcpy(gpu->framebuffer + i, gpu->colorPalette[0], 4);
         }
         gpu->fbUpdated = true;
         return;
     }
 
-    if (getBit(LCDC, 0)) {
-        //renderBackground(gpu, mem);
-        if (getBit(LCDC, 5)) renderWindow(gpu, mem);
-    };
-    if (getBit(LCDC, 1)) renderObjects(gpu, mem);
+    // Background, window and sprites were drawn line by line
     gpu->fbUpdated = true;
 }
\ No newline at end of file
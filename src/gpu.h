@@ -5,22 +5,35 @@
 
 typedef struct GPU GPU;
 
+#include "constants.h"
 #include "cpu.h"
 #include "memory.h"
 
+#define GPU_LINE_SPRITES 10 // sprites the OAM scan picks per line, any further ones are not drawn
+
 struct GPU {
     int machineCycleCounter;
-    uint8_t* framebuffer;
+    uint8_t framebuffer[GB_SCREEN_WIDTH * GB_SCREEN_HEIGHT * 4];
     bool fbUpdated;
+    int windowLine; // window line to draw next, counts only lines the window was drawn on and restarts every frame
+
+    // Sprites on the current line as found by the OAM scan in mode 2 (OAM entry numbers, highest priority first), and
+    // the background/window color numbers drawn on the line, which sprites flagged to stay behind them check
+    uint8_t lineSprites[GPU_LINE_SPRITES];
+    int lineSpritesNo;
+    uint8_t lineColors[GB_SCREEN_WIDTH];
+
+    uint8_t colorPalette[4][4]; // RGBA shades of the LCD
 
-    uint8_t* backgroundMap;
-    uint8_t* windowMap;
+    // RGBA pixel for each color number under BGP, OBP0 and OBP1, rebuilt whenever one of them is written
+    uint32_t palettes[3][4];
 
-    uint8_t colorPalette[4][4];
+    // All 384 tiles decoded to one color number (0-3) per pixel, row by row. A tile is decoded again the next time
+    // it is drawn after a write to its VRAM (see MEM_isTileDirty).
+    _Alignas(64) uint8_t tileCache[384][8 * 8];
 };
 
-void GPU_init(GPU* gpu);
-void GPU_destroy(GPU* gpu);
+void GPU_init(GPU* gpu, Memory* mem);
 void GPU_update(CPU* cpu, GPU* gpu, Memory* mem);
 void GPU_renderToFrameBuffer(GPU* gpu, Memory* mem);
 
@@ -0,0 +1,286 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inflate.h"
+
+// Decoder for raw deflate streams (RFC 1951), as found in gzip files and zip archives
+
+#define MAX_CODE_BITS 15
+#define LITLEN_CODES 288
+#define DIST_CODES 30
+
+typedef struct BitReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    uint32_t bits; // bits read from data but not consumed yet, LSB first
+    int bitsNo;
+    bool overrun;  // tried to read past the end of data
+} BitReader;
+
+// Canonical Huffman code: number of codes of each length and the symbols ordered by code
+typedef struct Huffman {
+    uint16_t counts[MAX_CODE_BITS + 1];
+    uint16_t symbols[LITLEN_CODES];
+} Huffman;
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[DIST_CODES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+    6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[DIST_CODES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static uint32_t getBits(BitReader* in, int count);
+static bool buildHuffman(Huffman* h, const uint8_t* lengths, int codesNo);
+static int decodeSymbol(BitReader* in, const Huffman* h);
+static bool readStoredBlock(BitReader* in, InflateOutput* out);
+static bool readDynamicTables(BitReader* in, Huffman* litLen, Huffman* dist);
+static bool inflateBlock(BitReader* in, const Huffman* litLen, const Huffman* dist, InflateOutput* out);
+static bool reserve(InflateOutput* out, size_t count);
+static void buildCrcTable(void);
+
+// Decompress a raw deflate stream into out, appending to whatever it already holds. consumed is set to the number
+// of bytes of data the stream took up. False if the stream is corrupt or truncated (or memory ran out).
+bool INF_inflate(const uint8_t* data, size_t size, size_t* consumed, InflateOutput* out) {
+    BitReader in = {data, size, 0, 0, 0, false};
+    Huffman litLen, dist;
+
+    bool last = false;
+    while (!last) {
+        last = getBits(&in, 1);
+        switch (getBits(&in, 2)) {
+            case 0:
+                if (!readStoredBlock(&in, out)) return false;
+                break;
+
+            case 1: {
+                // Fixed codes
+                uint8_t lengths[LITLEN_CODES];
+                memset(lengths, 8, 144);
+                memset(lengths + 144, 9, 256 - 144);
+                memset(lengths + 256, 7, 280 - 256);
+                memset(lengths + 280, 8, LITLEN_CODES - 280);
+                buildHuffman(&litLen, lengths, LITLEN_CODES);
+                memset(lengths, 5, DIST_CODES);
+                buildHuffman(&dist, lengths, DIST_CODES);
+                if (!inflateBlock(&in, &litLen, &dist, out)) return false;
+                break;
+            }
+
+            case 2:
+                if (!readDynamicTables(&in, &litLen, &dist) || !inflateBlock(&in, &litLen, &dist, out)) return false;
+                break;
+
+            default:
+                return false;
+        }
+        if (in.overrun) return false;
+    }
+
+    *consumed = in.pos;
+    return true;
+}
+
+// CRC-32 as used by gzip and zip
+uint32_t INF_crc32(const uint8_t* data, size_t size) {
+    pthread_once(&crcTableOnce, buildCrcTable);
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t getBits(BitReader* in, int count) {
+    uint32_t bits = in->bits;
+    while (in->bitsNo < count) {
+        if (in->pos == in->size) {
+            in->overrun = true;
+            return 0;
+        }
+        bits |= (uint32_t) in->data[(in->pos)++] << in->bitsNo;
+        in->bitsNo += 8;
+    }
+    in->bits = bits >> count;
+    in->bitsNo -= count;
+    return bits & ((UINT32_C(1) << count) - 1);
+}
+
+// Build a decoding table from code lengths (incomplete codes are allowed, over-subscribed ones are not)
+static bool buildHuffman(Huffman* h, const uint8_t* lengths, int codesNo) {
+    memset(h->counts, 0, sizeof(h->counts));
+    for (int i = 0; i < codesNo; ++i) {
+        ++(h->counts[lengths[i]]);
+    }
+
+    int left = 1;
+    for (int length = 1; length <= MAX_CODE_BITS; ++length) {
+        left = (left << 1) - h->counts[length];
+        if (left < 0) return false;
+    }
+
+    uint16_t offsets[MAX_CODE_BITS + 1];
+    offsets[1] = 0;
+    for (int length = 1; length < MAX_CODE_BITS; ++length) {
+        offsets[length + 1] = offsets[length] + h->counts[length];
+    }
+    for (int i = 0; i < codesNo; ++i) {
+        if (lengths[i] != 0) h->symbols[(offsets[lengths[i]])++] = i;
+    }
+    return true;
+}
+
+// Decode one symbol, -1 if the bits do not form a code
+static int decodeSymbol(BitReader* in, const Huffman* h) {
+    int code = 0;  // bits read so far
+    int first = 0; // first code of the current length
+    int index = 0; // index of that code's symbol
+    for (int length = 1; length <= MAX_CODE_BITS; ++length) {
+        code |= getBits(in, 1);
+        int count = h->counts[length];
+        if (code - first < count) return h->symbols[index + (code - first)];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static bool readStoredBlock(BitReader* in, InflateOutput* out) {
+    // Stored blocks start on a byte boundary (the reader never holds a whole unused byte)
+    in->bits = 0;
+    in->bitsNo = 0;
+    if (in->size - in->pos < 4) return false;
+
+    const uint8_t* header = in->data + in->pos;
+    size_t length = header[0] | (header[1] << 8);
+    if ((size_t) (header[2] | (header[3] << 8)) != (~length & 0xFFFF)) return false;
+    in->pos += 4;
+    if (in->size - in->pos < length || !reserve(out, length)) return false;
+
+    memcpy(out->data + out->size, in->data + in->pos, length);
+    out->size += length;
+    in->pos += length;
+    return true;
+}
+
+static bool readDynamicTables(BitReader* in, Huffman* litLen, Huffman* dist) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    int litLenNo = getBits(in, 5) + 257;
+    int distNo = getBits(in, 5) + 1;
+    int codeLengthsNo = getBits(in, 4) + 4;
+    if (litLenNo > 286 || distNo > DIST_CODES) return false;
+
+    // Code lengths are themselves Huffman coded
+    uint8_t lengths[LITLEN_CODES + DIST_CODES] = {0};
+    for (int i = 0; i < codeLengthsNo; ++i) {
+        lengths[order[i]] = getBits(in, 3);
+    }
+    Huffman lengthCode;
+    if (!buildHuffman(&lengthCode, lengths, 19)) return false;
+
+    for (int i = 0; i < litLenNo + distNo;) {
+        int symbol = decodeSymbol(in, &lengthCode);
+        if (symbol < 0 || in->overrun) return false;
+        if (symbol < 16) {
+            lengths[i++] = symbol;
+            continue;
+        }
+
+        // Repeats: 16 copies the previous length 3-6 times, 17 and 18 are runs of 3-10 and 11-138 zeros
+        uint8_t length = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (i == 0) return false;
+            length = lengths[i - 1];
+            repeat = 3 + getBits(in, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + getBits(in, 3);
+        } else {
+            repeat = 11 + getBits(in, 7);
+        }
+        if (i + repeat > litLenNo + distNo) return false;
+        while (repeat-- > 0) {
+            lengths[i++] = length;
+        }
+    }
+
+    // A block without an end-of-block code could never end
+    if (lengths[256] == 0) return false;
+    return buildHuffman(litLen, lengths, litLenNo) && buildHuffman(dist, lengths + litLenNo, distNo);
+}
+
+static bool inflateBlock(BitReader* in, const Huffman* litLen, const Huffman* dist, InflateOutput* out) {
+    while (true) {
+        int symbol = decodeSymbol(in, litLen);
+        if (symbol < 0 || in->overrun) return false;
+
+        if (symbol < 256) {
+            if (!reserve(out, 1)) return false;
+            out->data[(out->size)++] = symbol;
+        } else if (symbol == 256) {
+            return true;
+        } else {
+            // Back-reference into the output
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = lengthBase[symbol] + getBits(in, lengthExtra[symbol]);
+
+            int distSymbol = decodeSymbol(in, dist);
+            if (distSymbol < 0 || distSymbol >= DIST_CODES) return false;
+            size_t distance = distBase[distSymbol] + getBits(in, distExtra[distSymbol]);
+            if (in->overrun || distance > out->size || !reserve(out, length)) return false;
+
+            // Byte by byte, the source may overlap the bytes being written
+            uint8_t* target = out->data + out->size;
+            const uint8_t* source = target - distance;
+            for (size_t i = 0; i < length; ++i) {
+                target[i] = source[i];
+            }
+            out->size += length;
+        }
+    }
+}
+
+// Make room for count more bytes of output
+static bool reserve(InflateOutput* out, size_t count) {
+    if (out->size + count <= out->capacity) return true;
+    if (out->limit != 0 && out->size + count > out->limit) return false;
+
+    size_t capacity = out->nextCapacity != NULL ? out->nextCapacity(out) : 0;
+    if (capacity < out->size + count) {
+        capacity = out->capacity * 2 > 0x1000 ? out->capacity * 2 : 0x1000;
+        while (capacity < out->size + count) capacity *= 2;
+    }
+    if (out->limit != 0 && capacity > out->limit) capacity = out->limit;
+
+    uint8_t* data = realloc(out->data, capacity);
+    if (data == NULL) return false;
+    out->data = data;
+    out->capacity = capacity;
+    return true;
+}
+
+static void buildCrcTable(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        crcTable[i] = crc;
+    }
+}
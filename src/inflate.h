@@ -0,0 +1,25 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+typedef struct InflateOutput InflateOutput;
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Output buffer of INF_inflate, grown with realloc as the data comes in
+struct InflateOutput {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+
+    // Capacity to grow the buffer to when it is full, NULL (or any value that is too small) doubles it
+    size_t (*nextCapacity)(const InflateOutput* out);
+
+    size_t limit; // inflating fails once the output would grow past this many bytes, 0 for no limit
+};
+
+bool INF_inflate(const uint8_t* data, size_t size, size_t* consumed, InflateOutput* out);
+uint32_t INF_crc32(const uint8_t* data, size_t size);
+
+#endif
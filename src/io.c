@@ -0,0 +1,176 @@
+#define _GNU_SOURCE // renameat2
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "io.h"
+
+typedef struct FileWrite {
+    char* path;
+    uint8_t* data;
+    size_t size;
+} FileWrite;
+
+static void* runWorker(void* arg);
+static void writeFile(void* context);
+
+void IO_init(IOWorker* io, size_t capacity) {
+    io->queue = malloc(capacity * sizeof(*io->queue)); // freed in IO_destroy
+    io->capacity = capacity;
+    io->head = 0;
+    io->count = 0;
+    io->busy = false;
+    io->stopping = false;
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->changed, NULL);
+
+    if (io->queue == NULL || pthread_create(&io->thread, NULL, runWorker, io) != 0) {
+        perror("Could not start I/O thread");
+        exit(1);
+    }
+}
+
+// Finish all queued jobs and stop the thread
+void IO_destroy(IOWorker* io) {
+    pthread_mutex_lock(&io->lock);
+    io->stopping = true;
+    pthread_cond_broadcast(&io->changed);
+    pthread_mutex_unlock(&io->lock);
+    pthread_join(io->thread, NULL);
+
+    pthread_cond_destroy(&io->changed);
+    pthread_mutex_destroy(&io->lock);
+    free(io->queue);
+    free(io);
+    io = NULL;
+}
+
+// Queue a job unless the queue is full (never waits for the disk); on failure the caller keeps the context
+bool IO_trySubmit(IOWorker* io, IO_Job job, void* context) {
+    pthread_mutex_lock(&io->lock);
+    bool queued = io->count < io->capacity;
+    if (queued) {
+        io->queue[(io->head + io->count) % io->capacity] = (IOQueueEntry){job, context};
+        ++(io->count);
+        pthread_cond_broadcast(&io->changed);
+    }
+    pthread_mutex_unlock(&io->lock);
+    return queued;
+}
+
+// Queue a job, waiting for room if the queue is full
+void IO_submit(IOWorker* io, IO_Job job, void* context) {
+    pthread_mutex_lock(&io->lock);
+    while (io->count == io->capacity) {
+        pthread_cond_wait(&io->changed, &io->lock);
+    }
+    io->queue[(io->head + io->count) % io->capacity] = (IOQueueEntry){job, context};
+    ++(io->count);
+    pthread_cond_broadcast(&io->changed);
+    pthread_mutex_unlock(&io->lock);
+}
+
+// Wait until every queued job has finished
+void IO_flush(IOWorker* io) {
+    pthread_mutex_lock(&io->lock);
+    while (io->count != 0 || io->busy) {
+        pthread_cond_wait(&io->changed, &io->lock);
+    }
+    pthread_mutex_unlock(&io->lock);
+}
+
+// Replace a file with a buffer (taking ownership of it): written to <path>.tmp, fsynced and renamed over the file
+void IO_writeFile(IOWorker* io, const char* path, uint8_t* data, size_t size) {
+    FileWrite* write = malloc(sizeof(*write)); // freed in writeFile
+    write->path = strdup(path);
+    write->data = data;
+    write->size = size;
+    IO_submit(io, writeFile, write);
+}
+
+// pwrite that retries short writes
+bool IO_pwriteAll(int fd, const uint8_t* data, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t res = pwrite(fd, data, length, offset);
+        if (res < 0) return false;
+        data += res;
+        length -= res;
+        offset += res;
+    }
+    return true;
+}
+
+// Atomically swap two files, fails if either does not exist or the filesystem can't do it
+bool IO_exchangeFiles(const char* from, const char* to) {
+    #ifdef RENAME_EXCHANGE
+    return renameat2(AT_FDCWD, from, AT_FDCWD, to, RENAME_EXCHANGE) == 0;
+    #else
+    return false;
+    #endif
+}
+
+// Make a rename in the directory containing path durable
+void IO_syncDirectory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    char* dir = slash != NULL ? strndup(path, slash - path + 1) : strdup(".");
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
+
+static void* runWorker(void* arg) {
+    IOWorker* io = arg;
+
+    pthread_mutex_lock(&io->lock);
+    while (true) {
+        while (io->count == 0 && !io->stopping) {
+            pthread_cond_wait(&io->changed, &io->lock);
+        }
+        if (io->count == 0) break;
+
+        IOQueueEntry entry = io->queue[io->head];
+        io->head = (io->head + 1) % io->capacity;
+        --(io->count);
+        io->busy = true;
+        pthread_cond_broadcast(&io->changed);
+
+        // The lock is not held while the job touches the disk
+        pthread_mutex_unlock(&io->lock);
+        entry.job(entry.context);
+        pthread_mutex_lock(&io->lock);
+
+        io->busy = false;
+        pthread_cond_broadcast(&io->changed);
+    }
+    pthread_mutex_unlock(&io->lock);
+
+    return NULL;
+}
+
+static void writeFile(void* context) {
+    FileWrite* write = context;
+    size_t tmpPathLength = strlen(write->path) + 5;
+    char* tmpPath = malloc(tmpPathLength);
+    snprintf(tmpPath, tmpPathLength, "%s.tmp", write->path);
+
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && IO_pwriteAll(fd, write->data, write->size, 0) && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    if (ok && rename(tmpPath, write->path) == 0) {
+        IO_syncDirectory(write->path);
+    } else {
+        fprintf(stderr, "Error while writing %s: %s\n", write->path, strerror(errno));
+    }
+
+    free(tmpPath);
+    free(write->path);
+    free(write->data);
+    free(write);
+}
@@ -0,0 +1,45 @@
+#ifndef IO_H
+#define IO_H
+
+typedef struct IOWorker IOWorker;
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// A job run on the I/O thread. The job owns its context and frees it when done.
+typedef void (*IO_Job)(void* context);
+
+typedef struct IOQueueEntry {
+    IO_Job job;
+    void* context;
+} IOQueueEntry;
+
+// Background thread that runs file writes off the emulation thread, in submission order
+struct IOWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed; // signalled whenever the queue or the busy flag changes
+
+    IOQueueEntry* queue;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    bool busy;
+    bool stopping;
+};
+
+void IO_init(IOWorker* io, size_t capacity);
+void IO_destroy(IOWorker* io);
+bool IO_trySubmit(IOWorker* io, IO_Job job, void* context);
+void IO_submit(IOWorker* io, IO_Job job, void* context);
+void IO_flush(IOWorker* io);
+void IO_writeFile(IOWorker* io, const char* path, uint8_t* data, size_t size);
+
+bool IO_pwriteAll(int fd, const uint8_t* data, size_t length, off_t offset);
+bool IO_exchangeFiles(const char* from, const char* to);
+void IO_syncDirectory(const char* path);
+
+#endif
@@ -1,11 +1,13 @@
-#include <stdlib.h>
-
 #include "common/bitwise.h"
 #include "constants.h"
 #include "memory.h"
 #include "joypad.h"
 
-void JOY_init(Joypad* joy) {
+static uint8_t getJoyp(Joypad* joy, uint8_t JOYP);
+static uint8_t readJoyp(void* context, Memory* mem, uint16_t address);
+static void writeJoyp(void* context, Memory* mem, uint16_t address, uint8_t value);
+
+void JOY_init(Joypad* joy, Memory* mem) {
     joy->a = 0;
     joy->b = 0;
     joy->start = 0;
@@ -14,34 +16,51 @@ void JOY_init(Joypad* joy) {
     joy->down = 0;
     joy->left = 0;
     joy->right = 0;
-}
 
-void JOY_destroy(Joypad* joy) {
-    free(joy);
-    joy = NULL;
+    MEM_setIoHook(mem, REG_JOYP, readJoyp, writeJoyp, joy);
 }
 
+// Call after a button is pressed: requests the joypad interrupt if a selected button is held
 void JOY_update(Joypad* joy, Memory* mem) {
-    uint8_t* JOYP = &(mem->logicalMemory[REG_JOYP]);
-    *JOYP |= 0xCF;
+    if ((getJoyp(joy, mem->ioRegisters[REG_JOYP - OFFSET_IOREGISTERS]) & 0xF) != 0xF) {
+        // Request joypad interrupt
+        mem->ioRegisters[REG_IF - OFFSET_IOREGISTERS] |= 0x10;
+    }
+}
 
-    if (!getBit(*JOYP, 5)) {
+// Compute JOYP from the button state and the selection bits
+static uint8_t getJoyp(Joypad* joy, uint8_t JOYP) {
+    JOYP |= 0xCF;
+
+    if (!getBit(JOYP, 5)) {
         // Action buttons
-        if (joy->a) *JOYP = setBit(*JOYP, 0, 0);
-        if (joy->b) *JOYP = setBit(*JOYP, 1, 0);
-        if (joy->select) *JOYP = setBit(*JOYP, 2, 0);
-        if (joy->start) *JOYP = setBit(*JOYP, 3, 0);
+        if (joy->a) JOYP = setBit(JOYP, 0, 0);
+        if (joy->b) JOYP = setBit(JOYP, 1, 0);
+        if (joy->select) JOYP = setBit(JOYP, 2, 0);
+        if (joy->start) JOYP = setBit(JOYP, 3, 0);
     }
-    if (!getBit(*JOYP, 4)) {
+    if (!getBit(JOYP, 4)) {
         // Direction buttons
-        if (joy->right) *JOYP = setBit(*JOYP, 0, 0);
-        if (joy->left) *JOYP = setBit(*JOYP, 1, 0);
-        if (joy->up) *JOYP = setBit(*JOYP, 2, 0);
-        if (joy->down) *JOYP = setBit(*JOYP, 3, 0);
+        if (joy->right) JOYP = setBit(JOYP, 0, 0);
+        if (joy->left) JOYP = setBit(JOYP, 1, 0);
+        if (joy->up) JOYP = setBit(JOYP, 2, 0);
+        if (joy->down) JOYP = setBit(JOYP, 3, 0);
     }
 
-    if ((*JOYP & 0xF) != 0xF) {
-        // Request joypad interrupt
-        mem->logicalMemory[REG_IF] |= 0x10;
+    return JOYP;
+}
+
+static uint8_t readJoyp(void* context, Memory* mem, uint16_t address) {
+    return getJoyp(context, mem->ioRegisters[REG_JOYP - OFFSET_IOREGISTERS]);
+}
+
+// Only the selection bits are writable. Selecting a row in which a button is already held pulls its input line from
+// high to low, which requests the joypad interrupt just like a press does.
+static void writeJoyp(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    uint8_t* JOYP = &(mem->ioRegisters[REG_JOYP - OFFSET_IOREGISTERS]);
+    uint8_t before = getJoyp(context, *JOYP);
+    *JOYP = 0xCF | (value & 0x30);
+    if ((before & ~getJoyp(context, *JOYP)) & 0xF) {
+        mem->ioRegisters[REG_IF - OFFSET_IOREGISTERS] |= 0x10;
     }
 }
\ No newline at end of file
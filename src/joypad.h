@@ -3,12 +3,13 @@
 
 typedef struct Joypad Joypad;
 
+#include "memory.h"
+
 struct Joypad {
     int a, b, start, select, up, down, left, right;
 };
 
-void JOY_init(Joypad* joy);
-void JOY_destroy(Joypad* joy);
+void JOY_init(Joypad* joy, Memory* mem);
 void JOY_update(Joypad* joy, Memory* mem);
 
 #endif
\ No newline at end of file
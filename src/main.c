@@ -8,44 +8,66 @@
 #include "common/bitwise.h"
 #include "audio.h"
 #include "constants.h"
-#include "cpu.h"
-#include "gpu.h"
-#include "joypad.h"
-#include "memory.h"
-#include "timer.h"
+#include "gameboy.h"
+#include "io.h"
 
-int quit(CPU* cpu, GPU* gpu, Memory* mem, Audio* audio, Timer* timer, Joypad* joy, int returnCode);
+int quit(GameBoy* gb, IOWorker* io, int returnCode);
+static bool parseWatchpoint(const char* spec, bool pause, MEM_Watchpoint* watchpoint);
+static void printWatchHit(const MEM_WatchHit* hit);
+static void printStats(const Memory* mem);
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        printf("Usage: %s <path to ROM>\n", argv[0]);
+    // Parse options
+    SaveMode saveMode = SAVE_ON_EXIT;
+    bool stats = false;
+    MEM_Watchpoint watchpoints[MEM_MAX_WATCHPOINTS];
+    int watchpointsNo = 0;
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--save=exit") == 0) {
+            saveMode = SAVE_ON_EXIT;
+        } else if (strcmp(argv[i], "--save=mmap") == 0) {
+            saveMode = SAVE_MAPPED;
+        } else if (strcmp(argv[i], "--save=incremental") == 0) {
+            saveMode = SAVE_INCREMENTAL;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if ((strncmp(argv[i], "--watch=", 8) == 0 || strncmp(argv[i], "--break=", 8) == 0)
+            && watchpointsNo < MEM_MAX_WATCHPOINTS
+            && parseWatchpoint(argv[i] + 8, argv[i][2] == 'b', &(watchpoints[watchpointsNo]))) {
+            ++watchpointsNo;
+        } else {
+            argc = 0; // print usage
+            break;
+        }
+    }
+    if (argc < 2) {
+        printf("Usage: %s [--save=exit|mmap|incremental] [--stats] [--watch=<rwx>:<start>[-<end>][@<bank>]]... [--break=...]... <path to ROM>\n", argv[0]);
         return 1;
     }
 
-    Memory* mem = malloc(sizeof(*mem)); // freed in quit
-    MEM_init(mem);
-    MEM_loadROM(mem, argv[1]);
+    IOWorker* io = malloc(sizeof(*io)); // freed in quit
+    IO_init(io, IO_QUEUE_CAPACITY);
+
+    GameBoy* gb = GB_create(argv[argc - 1], saveMode, io, 0); // freed in quit
+    Memory* mem = gb->mem;
+    Joypad* joy = gb->joy;
 
     printf("ROM info:\n");
     printf("Title: %s\n", mem->cartridge->title);
     printf("Cartridge type: 0x%02x\n", mem->cartridge->type);
     printf("ROM size: 0x%02x\n", mem->cartridge->romSize);
     printf("RAM size: 0x%02x\n", mem->cartridge->ramSize);
+    printf("CRC32C: %08x\n", mem->rom->hash);
 
-    CPU* cpu = malloc(sizeof(*cpu)); // freed in quit
-    CPU_init(cpu);
-
-    GPU* gpu = malloc(sizeof(*gpu)); // freed in quit
-    GPU_init(gpu);
-
-    Timer* timer = malloc(sizeof(*timer)); // freed in quit
-    TIMER_init(timer);
-
-    Joypad* joy = malloc(sizeof(*joy)); // freed in quit
-    JOY_init(joy);
+    for (int i = 0; i < watchpointsNo; ++i) {
+        MEM_addWatchpoint(mem, watchpoints[i]);
+    }
+    if (stats) {
+        MEM_enableStats(mem);
+    }
 
-    Audio* audio = malloc(sizeof(*audio)); // freed in quit
-    AUD_init(audio, 44100);
+    gb->audio = malloc(sizeof(*gb->audio)); // freed in quit
+    AUD_init(gb->audio, mem, 44100);
 
     #ifndef DISABLE_GRAPHICS
     // Init graphics
@@ -58,25 +80,34 @@ int main(int argc, char** argv) {
 
     SDL_Event event;
     uint64_t startTime = SDL_GetPerformanceCounter();
+    uint64_t lastSaveSync = 0;
 
     while (1) {
-        int res = CPU_emulateCycle(cpu, gpu, mem, timer, joy);
+        int res = GB_emulateCycle(gb);
         if (!res) {
-            return quit(cpu, gpu, mem, audio, timer, joy, 1);
+            return quit(gb, io, 1);
         }
-        GPU_update(cpu, gpu, mem);
-        TIMER_update(cpu, mem, timer);
-        MEM_dmaUpdate(mem);
-        JOY_update(joy, mem);
-        AUD_update(audio, mem);
-
-        #ifndef DISABLE_GRAPHICS
-        if (gpu->fbUpdated) {
+
+        if (mem->watchPaused) {
+            printWatchHit(&(mem->watchHits[(mem->watchHitsNo - 1) % MEM_WATCH_HISTORY]));
+            printf("Paused, press Enter to continue\n");
+            getchar();
+            mem->watchPaused = false;
+        }
+
+        if (gb->gpu->fbUpdated) {
+            // Periodically flush battery RAM (on the I/O thread, frame pacing never waits for the disk)
+            if (mem->save != NULL && mem->cycles - lastSaveSync >= SAVE_SYNC_INTERVAL) {
+                MEM_syncSave(mem);
+                lastSaveSync = mem->cycles;
+            }
+
+            #ifndef DISABLE_GRAPHICS
             // Handle events
             while (SDL_PollEvent(&event)) {
                 switch (event.type) {
                     case SDL_QUIT:
-                        return quit(cpu, gpu, mem, audio, timer, joy, 0);
+                        return quit(gb, io, 0);
 
                     case SDL_KEYDOWN:
                         switch (event.key.keysym.sym) {
@@ -89,6 +120,7 @@ int main(int argc, char** argv) {
                             case SDLK_LEFT: joy->left = 1; break;
                             case SDLK_RIGHT: joy->right = 1; break;
                         }
+                        JOY_update(joy, mem);
                         break;
 
                     case SDL_KEYUP:
@@ -107,42 +139,101 @@ int main(int argc, char** argv) {
             }
 
             // Update the screen
-            SDL_UpdateTexture(texture, NULL, gpu->framebuffer, GB_SCREEN_WIDTH * 4);
+            SDL_UpdateTexture(texture, NULL, gb->gpu->framebuffer, GB_SCREEN_WIDTH * 4);
             SDL_RenderClear(renderer);
             SDL_RenderCopy(renderer, texture, NULL, NULL);
             SDL_RenderPresent(renderer);
-            gpu->fbUpdated = false;
+            gb->gpu->fbUpdated = false;
 
             // Maintain 60fps
             double targetTime = 1.0 / 60.0;
             while (((SDL_GetPerformanceCounter() - startTime) / (float) SDL_GetPerformanceFrequency()) < targetTime);
             printf("FPS %.2f\r", 1.0 / ((SDL_GetPerformanceCounter() - startTime) / (float) SDL_GetPerformanceFrequency()));
             startTime = SDL_GetPerformanceCounter();
+            #endif
         }
-        #endif
     }
 }
 
-int quit(CPU* cpu, GPU* gpu, Memory* mem, Audio* audio, Timer* timer, Joypad* joy, int returnCode) {
-    // Dump external RAM to save
-    if (mem->battery) {
-        char* saveFileName = malloc(strlen(mem->romPath) + 5); // freed at the end of this block
-        snprintf(saveFileName, strlen(mem->romPath) + 5, "%s.sav", mem->romPath);
-        FILE* file = fopen(saveFileName, "wb+");
-        for (int i = 0; i < (mem->extRamBanksNo * 0x2000); ++i) {
-            fputc(mem->extRamBanks[i], file);
+int quit(GameBoy* gb, IOWorker* io, int returnCode) {
+    Memory* mem = gb->mem;
+
+    // Dump the most recent watchpoint hits
+    if (mem->watchHitsNo != 0) {
+        uint64_t first = mem->watchHitsNo > MEM_WATCH_HISTORY ? mem->watchHitsNo - MEM_WATCH_HISTORY : 0;
+        printf("%llu watchpoint hits, most recent:\n", (unsigned long long) mem->watchHitsNo);
+        for (uint64_t i = first; i < mem->watchHitsNo; ++i) {
+            printWatchHit(&(mem->watchHits[i % MEM_WATCH_HISTORY]));
         }
-        fclose(file);
-        free(saveFileName);
     }
 
-    // Destroy components
-    CPU_destroy(cpu);
-    GPU_destroy(gpu);
-    MEM_destroy(mem);
-    AUD_destroy(audio);
-    TIMER_destroy(timer);
-    JOY_destroy(joy);
+    if (mem->stats != NULL) {
+        printStats(mem);
+    }
+
+    // Destroy components (battery RAM is written out by GB_destroy)
+    AUD_destroy(gb->audio);
+    GB_destroy(gb);
+
+    // Wait for pending writes
+    IO_destroy(io);
 
     return returnCode;
-}
\ No newline at end of file
+}
+
+// Parse a watchpoint given as <rwx>:<start>[-<end>][@<bank>], with addresses and banks in hex
+static bool parseWatchpoint(const char* spec, bool pause, MEM_Watchpoint* watchpoint) {
+    watchpoint->access = 0;
+    for (; *spec != ':'; ++spec) {
+        switch (*spec) {
+            case 'r': watchpoint->access |= MEM_WATCH_READ; break;
+            case 'w': watchpoint->access |= MEM_WATCH_WRITE; break;
+            case 'x': watchpoint->access |= MEM_WATCH_EXECUTE; break;
+            default: return false;
+        }
+    }
+
+    char* end;
+    unsigned long start = strtoul(spec + 1, &end, 16);
+    unsigned long last = start;
+    long bank = -1;
+    if (end == spec + 1) return false;
+    if (*end == '-') last = strtoul(end + 1, &end, 16);
+    if (*end == '@') bank = strtol(end + 1, &end, 16);
+    if (*end != '\0' || watchpoint->access == 0 || last < start || last > 0xFFFF) return false;
+
+    watchpoint->start = start;
+    watchpoint->end = last;
+    watchpoint->bank = bank;
+    watchpoint->pause = pause;
+    return true;
+}
+
+static void printWatchHit(const MEM_WatchHit* hit) {
+    const char* access = hit->access == MEM_WATCH_READ ? "read" : (hit->access == MEM_WATCH_WRITE ? "write" : "execute");
+    printf("[WATCH] cycle %llu: %s %04x (bank %d) at PC %04x, %02x -> %02x\n", (unsigned long long) hit->cycle, access,
+        hit->address, hit->bank, hit->pc, hit->oldValue, hit->newValue);
+}
+
+static void printStats(const Memory* mem) {
+    static const char* regionNames[MEM_REGIONS] = {"ROM0", "ROMN", "VRAM", "ExtRAM", "WRAM", "OAM", "I/O", "HRAM"};
+    const MEM_Stats* stats = mem->stats;
+    double frames = mem->cycles / (double) GB_FRAME_CYCLES;
+    if (frames < 1.0) frames = 1.0;
+
+    printf("Memory accesses over %.0f frames (per frame in parentheses):\n", frames);
+    for (int i = 0; i < MEM_REGIONS; ++i) {
+        printf("%-6s  reads %12llu (%9.1f)  writes %12llu (%9.1f)\n", regionNames[i],
+            (unsigned long long) stats->reads[i], stats->reads[i] / frames,
+            (unsigned long long) stats->writes[i], stats->writes[i] / frames);
+    }
+    for (int i = 0; i < 0x80; ++i) {
+        if (stats->ioReads[i] == 0 && stats->ioWrites[i] == 0) continue;
+        printf("  %04x  reads %12llu (%9.1f)  writes %12llu (%9.1f)\n", OFFSET_IOREGISTERS + i,
+            (unsigned long long) stats->ioReads[i], stats->ioReads[i] / frames,
+            (unsigned long long) stats->ioWrites[i], stats->ioWrites[i] / frames);
+    }
+    printf("ROM bank switches %llu (%.2f per frame), RAM bank switches %llu (%.2f per frame)\n",
+        (unsigned long long) stats->romBankSwitches, stats->romBankSwitches / frames,
+        (unsigned long long) stats->ramBankSwitches, stats->ramBankSwitches / frames);
+}
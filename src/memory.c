@@ -9,13 +9,116 @@
 #include "constants.h"
 #include "cartridge.h"
 #include "memory.h"
+#include "rom.h"
+#include "save.h"
+
+static void powerOn(Memory* mem);
+static void mapPages(Memory* mem);
+static void mapRomPages(Memory* mem);
+static void mapExtRamPages(Memory* mem);
+static void publishPages(Memory* mem, int firstPage, int endPage);
+static uint8_t readBase(Memory* mem, uint16_t address);
+static uint8_t readOpenBus(Memory* mem, uint16_t address);
+static uint8_t readEchoRam(Memory* mem, uint16_t address);
+static uint8_t readHighPage(Memory* mem, uint16_t address);
+static void writeIgnored(Memory* mem, uint16_t address, uint8_t value);
+static void writeCleanExtRam(Memory* mem, uint16_t address, uint8_t value);
+static void writeSharedWorkRam(Memory* mem, uint16_t address, uint8_t value);
+static void writeSharedExtRam(Memory* mem, uint16_t address, uint8_t value);
+static void ownWorkRamPage(Memory* mem, int page);
+static void ownExtRamPage(Memory* mem, size_t offset);
+static bool isExtRamPageShared(const Memory* mem, size_t offset);
+static void writeVideoRam(Memory* mem, uint16_t address, uint8_t value);
+static void markVideoRamDirty(Memory* mem, uint16_t address);
+static void writeSpriteAttributeTable(Memory* mem, uint16_t address, uint8_t value);
+static void writeHighPage(Memory* mem, uint16_t address, uint8_t value);
+static uint8_t readIoRegister(void* context, Memory* mem, uint16_t address);
+static void writeIoRegister(void* context, Memory* mem, uint16_t address, uint8_t value);
+static void writeDma(void* context, Memory* mem, uint16_t address, uint8_t value);
+static uint8_t readDmaBlocked(Memory* mem, uint16_t address);
+static void writeDmaBlocked(Memory* mem, uint16_t address, uint8_t value);
+static void dmaEnd(Memory* mem);
+static uint8_t readWatched(Memory* mem, uint16_t address);
+static void writeWatched(Memory* mem, uint16_t address, uint8_t value);
+static void checkWatchpoints(Memory* mem, uint16_t address, MEM_WatchAccess access, uint8_t oldValue, uint8_t newValue);
+static int getBank(Memory* mem, uint16_t address);
+static uint8_t readCounted(Memory* mem, uint16_t address);
+static void writeCounted(Memory* mem, uint16_t address, uint8_t value);
+static uint8_t readUncounted(Memory* mem, uint16_t address);
+static void writeUncounted(Memory* mem, uint16_t address, uint8_t value);
 
 void MEM_init(Memory* mem) {
+    powerOn(mem);
+
+    // Initialize other variables
+    mem->save = NULL;
+    mem->cartridge = NULL;
+    mem->rom = NULL;
+    mem->romBanks = NULL;
+    mem->romBank0 = NULL;
+    mem->romBankN = NULL;
+    mem->extRam = NULL;
+    mem->extRamBanksNo = 0;
+    mem->extRamPlaced = false;
+    mem->extRamEnabled = false;
+
+    mem->watchpointsNo = 0;
+    memset(mem->watchedPages, 0, sizeof(mem->watchedPages));
+    mem->watchHits = NULL;
+    mem->watchHitsNo = 0;
+    mem->watchPaused = false;
+    mem->watchPc = NULL;
+    mem->stats = NULL;
+
+    mem->cowSource = NULL;
+    mem->cowWorkRamOwned = 0;
+    memset(mem->cowExtRamOwned, 0, sizeof(mem->cowExtRamOwned));
+
+    mapPages(mem);
+
+    // I/O registers are plain memory until a component hooks them
+    for (uint16_t address = OFFSET_IOREGISTERS; address < OFFSET_HIGHRAM; ++address) {
+        MEM_setIoHook(mem, address, NULL, NULL, NULL);
+    }
+    MEM_setIoHook(mem, REG_DMA, NULL, writeDma, NULL);
+}
+
+// Switch the Game Boy off and on again: RAM, registers and the MBC are back to their power-on state, battery RAM is
+// kept. The ROM, save file, I/O hooks, watchpoints and statistics stay as they are.
+void MEM_reset(Memory* mem) {
+    powerOn(mem);
+
+    if (mem->cartridge != NULL) {
+        CART_reset(mem->cartridge);
+    }
+    mem->romBankN = mem->romBanks != NULL ? mem->romBanks + 0x4000 : NULL;
+    mem->extRam = mem->extRamBanks;
+    mem->extRamEnabled = false;
+    mem->watchPaused = false;
+
+    bool battery = mem->cartridge != NULL && CART_hasBattery(mem->cartridge);
+    if (mem->extRamBanksNo != 0 && !battery) {
+        memset(mem->extRamBanks, 0, 0x2000 * mem->extRamBanksNo);
+    }
+
+    // A fork owns the RAM it just cleared (battery RAM stays shared until written)
+    if (mem->cowSource != NULL) {
+        mem->cowWorkRamOwned = 0xFFFFFFFF;
+        if (mem->extRamBanksNo != 0 && !battery) {
+            memset(mem->cowExtRamOwned, 0xFF, sizeof(mem->cowExtRamOwned));
+        }
+    }
+
+    mapPages(mem);
+}
+
+// Power-on state of RAM and registers
+static void powerOn(Memory* mem) {
     // Zero out memory
-    /*for (int i = 0; i < 0x10000; ++i) {
-        mem->logicalMemory[i] = 0;
-    }*/
-    memset(mem->logicalMemory, 0, 0x10000);
+    memset(mem->videoRam, 0, sizeof(mem->videoRam));
+    memset(mem->workRam, 0, sizeof(mem->workRam));
+    memset(mem->spritePage, 0, sizeof(mem->spritePage));
+    memset(mem->highPage, 0, sizeof(mem->highPage));
 
     // Set special registers
     mem->ioRegisters[REG_NR10 - OFFSET_IOREGISTERS] = 0x80;
@@ -38,114 +141,116 @@ void MEM_init(Memory* mem) {
     mem->ioRegisters[REG_OBP0 - OFFSET_IOREGISTERS] = 0xFF;
     mem->ioRegisters[REG_OBP1 - OFFSET_IOREGISTERS] = 0xFF;
 
-    // Initialize other variables
-    mem->battery = 0;
-    mem->dmaAddressUpper = 0;
-    mem->dmaInProgress = 0;
-    mem->dmaPosition = 0;
+    mem->cycles = 0;
+    mem->dmaActive = false;
+    mem->dmaEndCycle = 0;
+
+    // The tile cache starts out empty, so every tile counts as changed
+    memset(mem->videoTileDirty, 0xFF, sizeof(mem->videoTileDirty));
 }
 
 void MEM_destroy(Memory* mem) {
-    free(mem->cartridge);
-    mem->cartridge = NULL;
-    free(mem->romBanks);
-    mem->romBanks = NULL;
-    free(mem->extRamBanks);
-    mem->extRamBanks = NULL;
-    free(mem->romPath);
-    mem->romPath = NULL;
+    MEM_release(mem);
     free(mem);
     mem = NULL;
 }
 
-uint8_t MEM_getByte(Memory* mem, uint16_t address) {
-    if (address < OFFSET_ROMBANKN) {
-        // ROM bank 0
-        return mem->romBank0[address - OFFSET_ROMBANK0];
-
-    } else if (address < OFFSET_VIDEORAM) {
-        // ROM bank N
-        return mem->romBankN[address - OFFSET_ROMBANKN];
-
-    } else if (address >= OFFSET_EXTRAM && address < OFFSET_WORKRAMBANK0) {
-        // External RAM
-        return mem->extRamBanksNo != 0 && mem->extRamEnabled
-            ? mem->extRam[address - OFFSET_EXTRAM]
-            : 0xFF;
-
-    } else {
-        return mem->logicalMemory[address];
+// Free everything the memory holds but the struct itself, for memory that is part of a larger allocation
+void MEM_release(Memory* mem) {
+    mem->cartridge = NULL;
+    ROM_close(mem->rom);
+    mem->rom = NULL;
+    mem->romBanks = NULL;
+    if (mem->save != NULL) {
+        SAVE_close(mem->save);
+        mem->save = NULL;
+    } else if (!mem->extRamPlaced) {
+        free(mem->extRamBanks);
     }
+    mem->extRamBanks = NULL;
+    free(mem->watchHits);
+    mem->watchHits = NULL;
+    free(mem->stats);
+    mem->stats = NULL;
 }
 
-void MEM_setByte(Memory* mem, uint16_t address, uint8_t value) {
-    if ((address > 0xDFFF && address < 0xFE00) || (address > 0xFE9F && address < 0xFF00)) {
-        //fprintf(stdout, "[MEM] warning: attempt to write to restricted address %04x\n", address);
-    } else if (address < OFFSET_VIDEORAM) {
-        // Handle MBC operations
-        CART_mbcDispatch(mem, address, value);
-
-    } else if (address >= OFFSET_EXTRAM && address < OFFSET_WORKRAMBANK0 && mem->extRamBanksNo != 0 && mem->extRamEnabled) {
-        //printf("extram write %d\n", mem->extRamBanksNo);
-        //getchar();
-        // Set external RAM
-        mem->extRam[address - OFFSET_EXTRAM] = value;
-
-    } else if (address == REG_DIV) {
-        // Reset the DIV register
-        mem->logicalMemory[REG_DIV] = 0;
-
-    } else if (address == REG_DMA) {
-        // Initiate a DMA transfer
-        MEM_dmaBegin(mem, value);
-        mem->logicalMemory[address] = value;
-
-    } else if (address == REG_TAC) {
-        // Preserve last 3 bits only (set rest to 1)
-        mem->logicalMemory[address] = 0xF8 | (value & 0x7);
+// Attach read/write hooks to an I/O register (NULL hooks fall back to plain memory)
+void MEM_setIoHook(Memory* mem, uint16_t address, MEM_IoReadHook read, MEM_IoWriteHook write, void* context) {
+    MEM_IoHook* hook = &(mem->ioHooks[address - OFFSET_IOREGISTERS]);
+    hook->read = read != NULL ? read : readIoRegister;
+    hook->write = write != NULL ? write : writeIoRegister;
+    hook->context = context;
+}
 
-    } else {
-        mem->logicalMemory[address] = value;
+// Move the I/O hooks registered by one component over to another (a NULL newContext drops the hooks, leaving the
+// registers as plain memory). Hooks without a context belong to memory itself and are never moved.
+void MEM_retargetIoHooks(Memory* mem, const void* oldContext, void* newContext) {
+    if (oldContext == NULL) return;
+
+    for (int i = 0; i < 0x80; ++i) {
+        if (mem->ioHooks[i].context == oldContext) {
+            if (newContext != NULL) {
+                mem->ioHooks[i].context = newContext;
+            } else {
+                MEM_setIoHook(mem, OFFSET_IOREGISTERS + i, NULL, NULL, NULL);
+            }
+        }
     }
 }
 
-
+// Store a byte in the memory backing an address, bypassing handlers and hooks (ROM and disabled RAM are left alone)
 void MEM_forceSetByte(Memory* mem, uint16_t address, uint8_t value) {
-    mem->logicalMemory[address] = value;
+    if (address >= OFFSET_VIDEORAM && address < OFFSET_EXTRAM) {
+        if (mem->videoRam[address - OFFSET_VIDEORAM] != value) {
+            markVideoRamDirty(mem, address);
+        }
+        mem->videoRam[address - OFFSET_VIDEORAM] = value;
+    } else if (address >= OFFSET_EXTRAM && address < OFFSET_WORKRAMBANK0) {
+        if (mem->extRam != NULL) {
+            ownExtRamPage(mem, (mem->extRam - mem->extRamBanks) + (address - OFFSET_EXTRAM));
+            mem->extRam[address - OFFSET_EXTRAM] = value;
+        }
+    } else if (address >= OFFSET_WORKRAMBANK0 && address < OFFSET_SPRITEATTRIBUTETABLE) {
+        uint16_t offset = (address - OFFSET_WORKRAMBANK0) % sizeof(mem->workRam);
+        ownWorkRamPage(mem, offset >> 8);
+        mem->workRam[offset] = value;
+    } else if (address >= OFFSET_SPRITEATTRIBUTETABLE && address < OFFSET_IOREGISTERS) {
+        mem->spritePage[address - OFFSET_SPRITEATTRIBUTETABLE] = value;
+    } else if (address >= OFFSET_IOREGISTERS) {
+        mem->highPage[address - OFFSET_IOREGISTERS] = value;
+    }
 }
 
 void MEM_pushToStack(Memory* mem, uint16_t* SP, uint16_t value) {
-    MEM_setByte(mem, *SP - 1, (value & 0xFF00) >> 8);
-    MEM_setByte(mem, *SP - 2, value & 0x00FF);
     *SP -= 2;
+    if (mem->writePages[*SP >> 8] != NULL && (*SP & 0xFF) != 0xFF) {
+        MEM_setWord(mem, *SP, value); // plain memory, the order of the two stores cannot be observed
+    } else {
+        // Like the hardware, write the high byte first (watchpoints and I/O hooks see the writes in this order)
+        MEM_setByte(mem, *SP + 1, value >> 8);
+        MEM_setByte(mem, *SP, value & 0xFF);
+    }
 }
 
 uint16_t MEM_popFromStack(Memory* mem, uint16_t* SP) {
     *SP += 2;
-    uint8_t byteUpper = MEM_getByte(mem, *SP - 1);
-    uint8_t byteLower = MEM_getByte(mem, *SP - 2);
-    return (byteUpper << 8) | byteLower;
+    return MEM_getWord(mem, *SP - 2);
 }
 
-void MEM_loadROM(Memory* mem, const char* path) {
-    // Open file and get size
-    FILE* file = fopen(path, "rb");
-    if (file == NULL) {
-        perror("Error while opening ROM");
+void MEM_loadROM(Memory* mem, const char* path, SaveMode saveMode, IOWorker* io) {
+    // Map the ROM (shared with any other instance running the same file)
+    mem->rom = ROM_open(path); // closed in MEM_destroy
+    if (mem->rom == NULL) {
         exit(1);
     }
-    fseek(file, 0L, SEEK_END);
-    size_t filesize = ftell(file);
-    rewind(file);
-
-    // Load ROM into banks array
-    mem->romBanks = malloc(filesize); // freed in main.c:quit
-    assert(fread(mem->romBanks, 1, filesize, file) == filesize);
-    fclose(file);
+    if (mem->rom->size < 0x8000) {
+        fprintf(stderr, "Invalid ROM: file is too small (%zu bytes)\n", mem->rom->size);
+        exit(1);
+    }
+    mem->romBanks = mem->rom->data;
 
     // Load cartridge data
-    Cartridge* cart = mem->cartridge;
-    mem->cartridge = malloc(sizeof(*cart)); // freed in main.c:quit
+    mem->cartridge = &(mem->cartridgeData);
     CART_init(mem->cartridge, mem);
 
     // Set fixed bank to bank 0
@@ -155,39 +260,49 @@ void MEM_loadROM(Memory* mem, const char* path) {
     mem->romBankN = mem->romBanks + 0x4000;
 
     // Set number of banks
+    if (mem->cartridge->romSize > 8) {
+        fprintf(stderr, "Invalid ROM: unknown ROM size 0x%x\n", mem->cartridge->romSize);
+        exit(1);
+    }
     mem->romBanksNo = ((int[]){2, 4, 8, 16, 32, 64, 128, 256, 512})[mem->cartridge->romSize];
     printf("%d\n", mem->romBanksNo);
+    if (mem->rom->size != (size_t) mem->romBanksNo * 0x4000) {
+        fprintf(stderr, "Invalid ROM: header declares %d banks but the image is %zu bytes\n", mem->romBanksNo, mem->rom->size);
+        exit(1);
+    }
+
+    // Like the boot ROM, refuse to run a cartridge with a bad header checksum. A bad global checksum is only worth a
+    // warning, hardware never checks it and plenty of patched ROMs get it wrong.
+    if (CART_computeHeaderChecksum(mem->romBanks) != mem->cartridge->headerChecksum) {
+        fprintf(stderr, "Invalid ROM: header checksum mismatch\n");
+        exit(1);
+    }
+    if (CART_computeGlobalChecksum(mem->romBanks, mem->rom->size) != mem->cartridge->globalChecksum) {
+        fprintf(stderr, "Warning: global checksum mismatch\n");
+    }
 
     // Initialize external RAM
     mem->extRamEnabled = false;
+    if (mem->cartridge->ramSize > 5) {
+        fprintf(stderr, "Invalid ROM: unknown RAM size 0x%x\n", mem->cartridge->ramSize);
+        exit(1);
+    }
     mem->extRamBanksNo = ((int[]){0, 0, 1, 4, 16, 8})[mem->cartridge->ramSize];
 
-    if (mem->extRamBanksNo != 0) {
-        mem->extRamBanks = calloc(0x2000 * mem->extRamBanksNo, 1);
-        mem->extRam = mem->extRamBanks + 0;
-    } else {
-        mem->extRam = NULL;
-    }
-
-    // Handle saving if MBC includes battery
-    uint8_t mbcCode = mem->romBank0[0x0147];
-    if (strchr((const char []){0x03, 0x06, 0x09, 0x0D, 0x0F, 0x10, 0x13, 0x1B, 0x1E, 0x22, '\0'}, mbcCode)) {
-        mem->battery = 1;
-        mem->romPath = malloc(strlen(path) + 1); // freed in main.c:quit
-        strcpy(mem->romPath, path);
-        char* saveFileName = malloc(strlen(path) + 5); // freed at the end of this block
-        snprintf(saveFileName, strlen(path) + 5, "%s.sav", path);
-        FILE* saveFile = fopen(saveFileName, "rb");
-        if (saveFile != NULL) {
-            filesize = mem->extRamBanksNo * 0x2000;
-            assert(fread(mem->extRamBanks, 1, filesize, saveFile) == filesize);
-            fclose(saveFile);
+    // Battery-backed RAM comes from the save file, otherwise it starts out zeroed
+    mem->save = NULL;
+    mem->extRamBanks = NULL;
+    if (mem->extRamBanksNo != 0 && CART_hasBattery(mem->cartridge)) {
+        mem->save = &(mem->saveData);
+        mem->extRamBanks = SAVE_open(mem->save, path, 0x2000 * mem->extRamBanksNo, saveMode, io);
+        if (mem->extRamBanks == NULL) {
+            exit(1);
         }
-        free(saveFileName);
-
-    } else {
-        mem->battery = 0;
+    } else if (mem->extRamBanksNo != 0) {
+        mem->extRamBanks = calloc(0x2000 * mem->extRamBanksNo, 1); // freed in MEM_destroy
     }
+    mem->extRam = mem->extRamBanks;
+    mapPages(mem);
 }
 
 
@@ -212,31 +327,553 @@ void MEM_setRomBank(Memory* mem, uint8_t bankNo) {
     }
 
     mem->romBankN = mem->romBanks + (0x4000 * bankNo);
+    if (mem->stats != NULL) ++(mem->stats->romBankSwitches);
+    mapRomPages(mem);
+    publishPages(mem, OFFSET_ROMBANK0 >> 8, OFFSET_VIDEORAM >> 8);
 }
 
 void MEM_setRamBank(Memory* mem, uint8_t bankNo) {
     if (bankNo < mem->extRamBanksNo) {
+        if (mem->stats != NULL) ++(mem->stats->ramBankSwitches);
         mem->extRam = mem->extRamBanks + (0x2000 * bankNo);
+        mapExtRamPages(mem);
+        publishPages(mem, OFFSET_EXTRAM >> 8, OFFSET_WORKRAMBANK0 >> 8);
     }
 }
 
+void MEM_setRamEnabled(Memory* mem, bool enabled) {
+    // Games disable RAM once they are done writing to it - a good moment to flush the save
+    if (mem->extRamEnabled && !enabled && mem->save != NULL) {
+        MEM_syncSave(mem);
+    }
+
+    mem->extRamEnabled = enabled;
+    mapExtRamPages(mem);
+    publishPages(mem, OFFSET_EXTRAM >> 8, OFFSET_WORKRAMBANK0 >> 8);
+}
+
+// Queue a flush of battery RAM to the save file
+void MEM_syncSave(Memory* mem) {
+    SAVE_sync(mem->save);
+    if (mem->save->mode == SAVE_INCREMENTAL) {
+        // Saved pages are clean again, trap the next write to each of them
+        mapPages(mem);
+    }
+}
+
+// Size of the external RAM that is not backed by a save file (0 if there is none), see MEM_placeExtRam
+size_t MEM_getPlainExtRamSize(const Memory* mem) {
+    return mem->save == NULL ? 0x2000 * mem->extRamBanksNo : 0;
+}
+
+// Move external RAM that is not backed by a save file into storage owned by the caller, MEM_getPlainExtRamSize bytes
+void MEM_placeExtRam(Memory* mem, uint8_t* storage) {
+    size_t size = MEM_getPlainExtRamSize(mem);
+    if (size == 0) return;
+
+    memcpy(storage, mem->extRamBanks, size);
+    if (!mem->extRamPlaced) free(mem->extRamBanks);
+    mem->extRam = storage + (mem->extRam - mem->extRamBanks);
+    mem->extRamBanks = storage;
+    mem->extRamPlaced = true;
+    mapPages(mem);
+}
+
+// Add a watchpoint, trapping the pages it covers (false if there is no room for it)
+bool MEM_addWatchpoint(Memory* mem, MEM_Watchpoint watchpoint) {
+    if (mem->watchpointsNo == MEM_MAX_WATCHPOINTS || watchpoint.start > watchpoint.end) return false;
+
+    if (mem->watchHits == NULL) {
+        mem->watchHits = malloc(MEM_WATCH_HISTORY * sizeof(*mem->watchHits)); // freed in MEM_destroy
+    }
+    mem->watchpoints[(mem->watchpointsNo)++] = watchpoint;
+    for (int page = watchpoint.start >> 8; page <= watchpoint.end >> 8; ++page) {
+        mem->watchedPages[page] |= watchpoint.access;
+    }
+    publishPages(mem, 0x00, 0x100);
+    return true;
+}
+
+void MEM_clearWatchpoints(Memory* mem) {
+    mem->watchpointsNo = 0;
+    memset(mem->watchedPages, 0, sizeof(mem->watchedPages));
+    publishPages(mem, 0x00, 0x100);
+}
+
+// Opcode fetch from a page without a direct fetch entry (execute watchpoint or a handler-backed page)
+uint8_t MEM_fetchWatched(Memory* mem, uint16_t address) {
+    // A fetch only counts as an execute, not as a read
+    MEM_ReadHandler handler = mem->stats != NULL ? mem->stats->readHandlers[address >> 8] : mem->readHandlers[address >> 8];
+    uint8_t value = handler == readWatched ? readBase(mem, address) : readUncounted(mem, address);
+    if (handler != readDmaBlocked && (mem->watchedPages[address >> 8] & MEM_WATCH_EXECUTE)) {
+        checkWatchpoints(mem, address, MEM_WATCH_EXECUTE, value, value);
+    }
+    return value;
+}
+
+// Start counting accesses per region, per I/O register and bank switches. Every data access is trapped from now on.
+void MEM_enableStats(Memory* mem) {
+    if (mem->stats != NULL) return;
+
+    mem->stats = calloc(1, sizeof(*mem->stats)); // freed in MEM_destroy
+    publishPages(mem, 0x00, 0x100);
+}
+
+MEM_Region MEM_getRegion(uint16_t address) {
+    if (address < OFFSET_ROMBANKN) return MEM_REGION_ROM0;
+    if (address < OFFSET_VIDEORAM) return MEM_REGION_ROMN;
+    if (address < OFFSET_EXTRAM) return MEM_REGION_VRAM;
+    if (address < OFFSET_WORKRAMBANK0) return MEM_REGION_EXTRAM;
+    if (address < OFFSET_SPRITEATTRIBUTETABLE) return MEM_REGION_WRAM;
+    if (address < OFFSET_IOREGISTERS) return MEM_REGION_OAM;
+    if (address < OFFSET_HIGHRAM) return MEM_REGION_IO;
+    return MEM_REGION_HRAM;
+}
+
+// Freeze the state of an instance into snapshot (allocated by the caller like any Memory). The snapshot has its own
+// copy of everything, never runs and never writes a save file; forks share its RAM pages until they write to them.
+void MEM_snapshot(Memory* snapshot, Memory* mem) {
+    memcpy(snapshot, mem, sizeof(*snapshot));
+    snapshot->save = NULL;
+    memset(&(snapshot->saveData), 0, sizeof(snapshot->saveData));
+    snapshot->watchHits = NULL;
+    snapshot->watchHitsNo = 0;
+    snapshot->watchPaused = false;
+    snapshot->watchPc = NULL;
+    snapshot->stats = NULL;
+    snapshot->cowSource = NULL;
+    snapshot->cowWorkRamOwned = 0;
+    memset(snapshot->cowExtRamOwned, 0, sizeof(snapshot->cowExtRamOwned));
+
+    // Pages a fork still shares are copied from its own snapshot
+    for (int page = 0; page < 0x20; ++page) {
+        if (mem->cowSource != NULL && !((mem->cowWorkRamOwned >> page) & 1)) {
+            memcpy(snapshot->workRam + (page << 8), mem->cowSource->workRam + (page << 8), 0x100);
+        }
+    }
+    if (mem->extRamBanksNo != 0) {
+        size_t size = 0x2000 * mem->extRamBanksNo;
+        snapshot->extRamBanks = malloc(size); // freed in MEM_destroy
+        snapshot->extRamPlaced = false;
+        for (size_t offset = 0; offset < size; offset += 0x100) {
+            const Memory* owner = isExtRamPageShared(mem, offset) ? mem->cowSource : mem;
+            memcpy(snapshot->extRamBanks + offset, owner->extRamBanks + offset, 0x100);
+        }
+        snapshot->extRam = snapshot->extRamBanks + (mem->extRam - mem->extRamBanks);
+    }
+
+    if (mem->cartridge != NULL) {
+        snapshot->cartridge = &(snapshot->cartridgeData);
+    }
+    ROM_retain(snapshot->rom);
+    mapPages(snapshot);
+}
+
+// Start a new instance from a snapshot, which has to outlive it. Only the small state is copied up front: work RAM
+// and external RAM pages are shared with the snapshot until the fork first writes to them. VRAM is copied since the
+// renderer reads it directly. extRamStorage (owned by the caller, MEM_getPlainExtRamSize(snapshot) bytes) receives
+// the external RAM pages as the fork writes to them.
+void MEM_fork(Memory* child, const Memory* snapshot, uint8_t* extRamStorage) {
+    size_t workRamEnd = offsetof(Memory, workRam) + sizeof(snapshot->workRam);
+    memcpy(child, snapshot, offsetof(Memory, workRam));
+    memcpy((uint8_t*) child + workRamEnd, (const uint8_t*) snapshot + workRamEnd, sizeof(*child) - workRamEnd);
+    child->cowSource = snapshot;
+    child->cowWorkRamOwned = 0;
+    memset(child->cowExtRamOwned, 0, sizeof(child->cowExtRamOwned));
+
+    if (snapshot->extRamBanksNo != 0) {
+        child->extRamBanks = extRamStorage;
+        child->extRamPlaced = true;
+        child->extRam = child->extRamBanks + (snapshot->extRam - snapshot->extRamBanks);
+    }
+
+    if (snapshot->cartridge != NULL) {
+        child->cartridge = &(child->cartridgeData);
+    }
+
+    // Watchpoints carry over, their hits start from scratch
+    if (child->watchpointsNo != 0) {
+        child->watchHits = malloc(MEM_WATCH_HISTORY * sizeof(*child->watchHits)); // freed in MEM_destroy
+    }
+    ROM_retain(child->rom);
+    mapPages(child);
+}
+
+// Rebuild the page tables from the current memory state
+static void mapPages(Memory* mem) {
+    // ROM area: open bus until a ROM is loaded, writes are MBC register writes
+    for (int page = OFFSET_ROMBANK0 >> 8; page < OFFSET_VIDEORAM >> 8; ++page) {
+        mem->baseReadPages[page] = NULL;
+        mem->baseReadHandlers[page] = readOpenBus;
+        mem->baseWritePages[page] = NULL;
+        mem->baseWriteHandlers[page] = mem->cartridge != NULL ? mem->cartridge->mbcWrite : writeIgnored;
+    }
+
+    // VRAM (writes feed the renderer's dirty bits) and work RAM
+    for (int page = 0; page < 0x20; ++page) {
+        mem->baseReadPages[(OFFSET_VIDEORAM >> 8) + page] = mem->videoRam + (page << 8);
+        mem->baseReadHandlers[(OFFSET_VIDEORAM >> 8) + page] = NULL;
+        mem->baseWritePages[(OFFSET_VIDEORAM >> 8) + page] = NULL;
+        mem->baseWriteHandlers[(OFFSET_VIDEORAM >> 8) + page] = writeVideoRam;
+
+        // Work RAM pages a fork still shares with its snapshot are read from there and write-trapped
+        bool shared = mem->cowSource != NULL && !((mem->cowWorkRamOwned >> page) & 1);
+        mem->baseReadPages[(OFFSET_WORKRAMBANK0 >> 8) + page] = (shared ? mem->cowSource->workRam : mem->workRam) + (page << 8);
+        mem->baseReadHandlers[(OFFSET_WORKRAMBANK0 >> 8) + page] = NULL;
+        mem->baseWritePages[(OFFSET_WORKRAMBANK0 >> 8) + page] = shared ? NULL : mem->workRam + (page << 8);
+        mem->baseWriteHandlers[(OFFSET_WORKRAMBANK0 >> 8) + page] = shared ? writeSharedWorkRam : NULL;
+    }
+
+    // Echo RAM, OAM and the I/O page
+    for (int page = OFFSET_ECHORAM >> 8; page < OFFSET_SPRITEATTRIBUTETABLE >> 8; ++page) {
+        mem->baseReadPages[page] = NULL;
+        mem->baseReadHandlers[page] = readEchoRam;
+        mem->baseWritePages[page] = NULL;
+        mem->baseWriteHandlers[page] = writeIgnored;
+    }
+    mem->baseReadPages[OFFSET_SPRITEATTRIBUTETABLE >> 8] = mem->spritePage;
+    mem->baseReadHandlers[OFFSET_SPRITEATTRIBUTETABLE >> 8] = NULL;
+    mem->baseWritePages[OFFSET_SPRITEATTRIBUTETABLE >> 8] = NULL;
+    mem->baseWriteHandlers[OFFSET_SPRITEATTRIBUTETABLE >> 8] = writeSpriteAttributeTable;
+    mem->baseReadPages[OFFSET_IOREGISTERS >> 8] = NULL;
+    mem->baseReadHandlers[OFFSET_IOREGISTERS >> 8] = readHighPage;
+    mem->baseWritePages[OFFSET_IOREGISTERS >> 8] = NULL;
+    mem->baseWriteHandlers[OFFSET_IOREGISTERS >> 8] = writeHighPage;
+
+    // Switchable banks
+    if (mem->romBanks != NULL) {
+        mapRomPages(mem);
+    }
+    mapExtRamPages(mem);
+
+    publishPages(mem, 0x00, 0x100);
+}
+
+// Copy a range of the base page tables into the tables used for accesses, applying the overlays on top of the
+// memory map: the OAM DMA lockout, watchpoint traps and access counting
+static void publishPages(Memory* mem, int firstPage, int endPage) {
+    for (int page = firstPage; page < endPage; ++page) {
+        uint8_t watched = mem->watchedPages[page];
+        if (mem->dmaActive && page < OFFSET_IOREGISTERS >> 8) {
+            // The CPU can only reach the I/O page and HRAM while an OAM DMA transfer is running
+            mem->readPages[page] = NULL;
+            mem->readHandlers[page] = readDmaBlocked;
+            mem->writePages[page] = NULL;
+            mem->writeHandlers[page] = writeDmaBlocked;
+            watched = 0;
+        } else {
+            mem->readPages[page] = mem->baseReadPages[page];
+            mem->readHandlers[page] = mem->baseReadHandlers[page];
+            mem->writePages[page] = mem->baseWritePages[page];
+            mem->writeHandlers[page] = mem->baseWriteHandlers[page];
+        }
+
+        if (watched & MEM_WATCH_READ) {
+            mem->readPages[page] = NULL;
+            mem->readHandlers[page] = readWatched;
+        }
+        if (watched & MEM_WATCH_WRITE) {
+            mem->writePages[page] = NULL;
+            mem->writeHandlers[page] = writeWatched;
+        }
+        mem->fetchPages[page] = (watched & MEM_WATCH_EXECUTE) ? NULL : mem->readPages[page];
+
+        if (mem->stats != NULL) {
+            // The counting handlers forward to the entries computed above
+            mem->stats->readPages[page] = mem->readPages[page];
+            mem->stats->readHandlers[page] = mem->readHandlers[page];
+            mem->stats->writePages[page] = mem->writePages[page];
+            mem->stats->writeHandlers[page] = mem->writeHandlers[page];
+            mem->readPages[page] = NULL;
+            mem->readHandlers[page] = readCounted;
+            mem->writePages[page] = NULL;
+            mem->writeHandlers[page] = writeCounted;
+        }
+    }
+}
+
+// Point the base read page table at the current ROM banks
+static void mapRomPages(Memory* mem) {
+    for (int page = 0; page < 0x40; ++page) {
+        mem->baseReadPages[(OFFSET_ROMBANK0 >> 8) + page] = mem->romBank0 + (page << 8);
+        mem->baseReadPages[(OFFSET_ROMBANKN >> 8) + page] = mem->romBankN + (page << 8);
+    }
+}
+
+// Point the base page tables at the current external RAM bank, or at the open-bus handlers if it is disabled.
+// With incremental saves, pages that are clean since the last save are write-trapped to mark them dirty. Pages a
+// fork still shares with its snapshot are read from there and write-trapped.
+static void mapExtRamPages(Memory* mem) {
+    bool enabled = mem->extRamBanksNo != 0 && mem->extRamEnabled;
+    bool tracked = enabled && mem->save != NULL && mem->save->mode == SAVE_INCREMENTAL;
+    for (int page = 0; page < 0x20; ++page) {
+        size_t offset = (mem->extRam - mem->extRamBanks) + (page << 8);
+        bool shared = enabled && isExtRamPageShared(mem, offset);
+        bool trapped = tracked && !SAVE_isPageDirty(mem->save, offset);
+        mem->baseReadPages[(OFFSET_EXTRAM >> 8) + page] = !enabled ? NULL
+            : (shared ? mem->cowSource->extRamBanks + offset : mem->extRam + (page << 8));
+        mem->baseReadHandlers[(OFFSET_EXTRAM >> 8) + page] = readOpenBus;
+        mem->baseWritePages[(OFFSET_EXTRAM >> 8) + page] = enabled && !trapped && !shared ? mem->extRam + (page << 8) : NULL;
+        mem->baseWriteHandlers[(OFFSET_EXTRAM >> 8) + page] = shared ? writeSharedExtRam
+            : (trapped ? writeCleanExtRam : writeIgnored);
+    }
+}
+
+// Disabled external RAM, and the ROM area before a ROM is loaded
+static uint8_t readOpenBus(Memory* mem, uint16_t address) {
+    return 0xFF;
+}
+
+// Echo RAM mirrors work RAM (0xC000-0xDDFF)
+static uint8_t readEchoRam(Memory* mem, uint16_t address) {
+    return readBase(mem, address - (OFFSET_ECHORAM - OFFSET_WORKRAMBANK0));
+}
+
+// I/O registers, high RAM and IE
+static uint8_t readHighPage(Memory* mem, uint16_t address) {
+    if (address >= OFFSET_HIGHRAM) {
+        return mem->highPage[address - OFFSET_IOREGISTERS];
+    }
+    MEM_IoHook* hook = &(mem->ioHooks[address - OFFSET_IOREGISTERS]);
+    return hook->read(hook->context, mem, address);
+}
+
+// Echo RAM, disabled external RAM and the ROM area before a ROM is loaded
+static void writeIgnored(Memory* mem, uint16_t address, uint8_t value) {
+    //fprintf(stdout, "[MEM] warning: attempt to write to restricted address %04x\n", address);
+}
+
+// First write to a battery RAM page since the last save: mark it dirty and let further writes go straight through
+static void writeCleanExtRam(Memory* mem, uint16_t address, uint8_t value) {
+    uint16_t offset = address - OFFSET_EXTRAM;
+    SAVE_markPageDirty(mem->save, (mem->extRam - mem->extRamBanks) + offset);
+    mem->baseWritePages[address >> 8] = mem->extRam + (offset & 0xFF00);
+    publishPages(mem, address >> 8, (address >> 8) + 1);
+    mem->extRam[offset] = value;
+}
+
+// First write of a fork to a work RAM or external RAM page it shares with its snapshot
+static void writeSharedWorkRam(Memory* mem, uint16_t address, uint8_t value) {
+    ownWorkRamPage(mem, (address - OFFSET_WORKRAMBANK0) >> 8);
+    mem->workRam[address - OFFSET_WORKRAMBANK0] = value;
+}
+
+static void writeSharedExtRam(Memory* mem, uint16_t address, uint8_t value) {
+    ownExtRamPage(mem, (mem->extRam - mem->extRamBanks) + (address - OFFSET_EXTRAM));
+    mem->extRam[address - OFFSET_EXTRAM] = value;
+}
+
+// Give a fork its own copy of a work RAM page (0-31), remapping it so further accesses go straight to the copy
+static void ownWorkRamPage(Memory* mem, int page) {
+    if (mem->cowSource == NULL || ((mem->cowWorkRamOwned >> page) & 1)) return;
+
+    memcpy(mem->workRam + (page << 8), mem->cowSource->workRam + (page << 8), 0x100);
+    mem->cowWorkRamOwned |= UINT32_C(1) << page;
+    mem->baseReadPages[(OFFSET_WORKRAMBANK0 >> 8) + page] = mem->workRam + (page << 8);
+    mem->baseWritePages[(OFFSET_WORKRAMBANK0 >> 8) + page] = mem->workRam + (page << 8);
+    mem->baseWriteHandlers[(OFFSET_WORKRAMBANK0 >> 8) + page] = NULL;
+    publishPages(mem, (OFFSET_WORKRAMBANK0 >> 8) + page, (OFFSET_WORKRAMBANK0 >> 8) + page + 1);
+}
+
+// Same for the external RAM page containing offset (counted from the start of bank 0)
+static void ownExtRamPage(Memory* mem, size_t offset) {
+    if (!isExtRamPageShared(mem, offset)) return;
+
+    offset &= ~(size_t) 0xFF;
+    memcpy(mem->extRamBanks + offset, mem->cowSource->extRamBanks + offset, 0x100);
+    mem->cowExtRamOwned[offset >> 14] |= UINT64_C(1) << ((offset >> 8) % 64);
+    mapExtRamPages(mem);
+    publishPages(mem, OFFSET_EXTRAM >> 8, OFFSET_WORKRAMBANK0 >> 8);
+}
+
+static bool isExtRamPageShared(const Memory* mem, size_t offset) {
+    return mem->cowSource != NULL && !((mem->cowExtRamOwned[offset >> 14] >> ((offset >> 8) % 64)) & 1);
+}
+
+static void writeVideoRam(Memory* mem, uint16_t address, uint8_t value) {
+    if (mem->videoRam[address - OFFSET_VIDEORAM] != value) {
+        markVideoRamDirty(mem, address);
+        mem->videoRam[address - OFFSET_VIDEORAM] = value;
+    }
+}
+
+// Only tile data is cached, the renderer reads tile maps straight from VRAM
+static void markVideoRamDirty(Memory* mem, uint16_t address) {
+    if (address < OFFSET_TILEMAPS) {
+        int tile = (address - OFFSET_VIDEORAM) / 16;
+        mem->videoTileDirty[tile / 64] |= UINT64_C(1) << (tile % 64);
+    }
+}
+
+// OAM shares its page with the unusable region (0xFEA0-0xFEFF)
+static void writeSpriteAttributeTable(Memory* mem, uint16_t address, uint8_t value) {
+    if (address < OFFSET_UNUSABLE) {
+        mem->spriteAttributeTable[address - OFFSET_SPRITEATTRIBUTETABLE] = value;
+    }
+}
+
+static void writeHighPage(Memory* mem, uint16_t address, uint8_t value) {
+    if (address >= OFFSET_HIGHRAM) {
+        // High RAM and IE
+        mem->highPage[address - OFFSET_IOREGISTERS] = value;
+    } else {
+        MEM_IoHook* hook = &(mem->ioHooks[address - OFFSET_IOREGISTERS]);
+        hook->write(hook->context, mem, address, value);
+    }
+}
+
+static uint8_t readIoRegister(void* context, Memory* mem, uint16_t address) {
+    return mem->ioRegisters[address - OFFSET_IOREGISTERS];
+}
+
+static void writeIoRegister(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    mem->ioRegisters[address - OFFSET_IOREGISTERS] = value;
+}
+
 // Initiate a DMA transfer
+static void writeDma(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    MEM_dmaBegin(mem, value);
+    mem->ioRegisters[address - OFFSET_IOREGISTERS] = value;
+}
+
+
+// Run an OAM DMA transfer: the 160 bytes are copied at once, then the bus stays blocked for the
+// 160 machine cycles the transfer takes on hardware
 void MEM_dmaBegin(Memory* mem, uint8_t addressUpper) {
-    mem->dmaAddressUpper = addressUpper;
-    mem->dmaPosition = 0x00;
-    mem->dmaInProgress = 1;
+    if (mem->dmaActive) {
+        dmaEnd(mem);
+    }
+
+    // The DMA unit is not the CPU, so it reads through the base tables (no watchpoint hits)
+    const uint8_t* source = mem->baseReadPages[addressUpper];
+    if (source != NULL) {
+        memcpy(mem->spriteAttributeTable, source, 0xA0);
+    } else {
+        for (int i = 0; i < 0xA0; ++i) {
+            mem->spriteAttributeTable[i] = readBase(mem, (addressUpper << 8) | i);
+        }
+    }
+
+    mem->dmaActive = true;
+    mem->dmaEndCycle = mem->cycles + 160;
+    mapPages(mem);
+}
+
+// Accesses to blocked pages during a DMA transfer. The block is lifted lazily by the first access after it ends,
+// which then goes on underneath the counting overlay (readCounted already counted it when statistics are on).
+static uint8_t readDmaBlocked(Memory* mem, uint16_t address) {
+    if (mem->cycles < mem->dmaEndCycle) return 0xFF;
+    dmaEnd(mem);
+    return readUncounted(mem, address);
 }
 
-void MEM_dmaUpdate(Memory* mem) {
-    if (!mem->dmaInProgress) return;
-    uint16_t sourceAddress = (mem->dmaAddressUpper << 8) | mem->dmaPosition;
-    uint16_t destAddress = 0xFE00 | mem->dmaPosition;
-    MEM_setByte(mem, destAddress, MEM_getByte(mem, sourceAddress));
+static void writeDmaBlocked(Memory* mem, uint16_t address, uint8_t value) {
+    if (mem->cycles < mem->dmaEndCycle) return;
+    dmaEnd(mem);
+    writeUncounted(mem, address, value);
+}
+
+static void dmaEnd(Memory* mem) {
+    mem->dmaActive = false;
+    mapPages(mem);
+}
 
-    if (mem->dmaPosition == 0x9F) {
-        mem->dmaPosition = 0x00;
-        mem->dmaInProgress = 0;
+// Read through the base tables, bypassing the overlays
+static uint8_t readBase(Memory* mem, uint16_t address) {
+    const uint8_t* page = mem->baseReadPages[address >> 8];
+    return page != NULL
+        ? page[address & 0xFF]
+        : mem->baseReadHandlers[address >> 8](mem, address);
+}
+
+// Accesses to pages with watchpoints on them
+static uint8_t readWatched(Memory* mem, uint16_t address) {
+    uint8_t value = readBase(mem, address);
+    checkWatchpoints(mem, address, MEM_WATCH_READ, value, value);
+    return value;
+}
+
+static void writeWatched(Memory* mem, uint16_t address, uint8_t value) {
+    uint8_t oldValue = readBase(mem, address);
+    uint8_t* page = mem->baseWritePages[address >> 8];
+    if (page != NULL) {
+        page[address & 0xFF] = value;
+    } else {
+        mem->baseWriteHandlers[address >> 8](mem, address, value);
+    }
+    checkWatchpoints(mem, address, MEM_WATCH_WRITE, oldValue, value);
+}
+
+// Record a hit for the first watchpoint matching an access
+static void checkWatchpoints(Memory* mem, uint16_t address, MEM_WatchAccess access, uint8_t oldValue, uint8_t newValue) {
+    int bank = getBank(mem, address);
+    for (int i = 0; i < mem->watchpointsNo; ++i) {
+        MEM_Watchpoint* watchpoint = &(mem->watchpoints[i]);
+        if (!(watchpoint->access & access) || address < watchpoint->start || address > watchpoint->end) continue;
+        if (watchpoint->bank >= 0 && watchpoint->bank != bank) continue;
+
+        MEM_WatchHit* hit = &(mem->watchHits[mem->watchHitsNo % MEM_WATCH_HISTORY]);
+        hit->cycle = mem->cycles;
+        hit->address = address;
+        hit->pc = mem->watchPc != NULL ? *(mem->watchPc) : 0;
+        hit->bank = bank;
+        hit->access = access;
+        hit->oldValue = oldValue;
+        hit->newValue = newValue;
+        ++(mem->watchHitsNo);
+        if (watchpoint->pause) {
+            mem->watchPaused = true;
+        }
+        return;
+    }
+}
+
+// Bank currently mapped at an address (0 outside the switchable regions)
+static int getBank(Memory* mem, uint16_t address) {
+    if (address >= OFFSET_ROMBANKN && address < OFFSET_VIDEORAM && mem->romBanks != NULL) {
+        return (mem->romBankN - mem->romBanks) / 0x4000;
+    }
+    if (address >= OFFSET_EXTRAM && address < OFFSET_WORKRAMBANK0 && mem->extRamBanks != NULL) {
+        return (mem->extRam - mem->extRamBanks) / 0x2000;
+    }
+    return 0;
+}
+
+// Accesses while statistics are enabled
+static uint8_t readCounted(Memory* mem, uint16_t address) {
+    MEM_Region region = MEM_getRegion(address);
+    ++(mem->stats->reads[region]);
+    if (region == MEM_REGION_IO) ++(mem->stats->ioReads[address - OFFSET_IOREGISTERS]);
+    return readUncounted(mem, address);
+}
+
+static void writeCounted(Memory* mem, uint16_t address, uint8_t value) {
+    MEM_Region region = MEM_getRegion(address);
+    ++(mem->stats->writes[region]);
+    if (region == MEM_REGION_IO) ++(mem->stats->ioWrites[address - OFFSET_IOREGISTERS]);
+    writeUncounted(mem, address, value);
+}
+
+// Accesses through the tables underneath the counting overlay (the live tables if it is off)
+static uint8_t readUncounted(Memory* mem, uint16_t address) {
+    if (mem->stats == NULL) return MEM_getByte(mem, address);
+
+    const uint8_t* page = mem->stats->readPages[address >> 8];
+    return page != NULL
+        ? page[address & 0xFF]
+        : mem->stats->readHandlers[address >> 8](mem, address);
+}
+
+static void writeUncounted(Memory* mem, uint16_t address, uint8_t value) {
+    if (mem->stats == NULL) {
+        MEM_setByte(mem, address, value);
+        return;
+    }
+
+    uint8_t* page = mem->stats->writePages[address >> 8];
+    if (page != NULL) {
+        page[address & 0xFF] = value;
     } else {
-        ++(mem->dmaPosition);
+        mem->stats->writeHandlers[address >> 8](mem, address, value);
     }
-}
\ No newline at end of file
+}
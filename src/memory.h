@@ -1,63 +1,271 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
-typedef struct Memory Memory;
-
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+#include "common/endianness.h"
+
+typedef struct Memory Memory;
+typedef uint8_t (*MEM_ReadHandler)(Memory* mem, uint16_t address);
+typedef void (*MEM_WriteHandler)(Memory* mem, uint16_t address, uint8_t value);
+typedef uint8_t (*MEM_IoReadHook)(void* context, Memory* mem, uint16_t address);
+typedef void (*MEM_IoWriteHook)(void* context, Memory* mem, uint16_t address, uint8_t value);
+typedef struct MEM_IoHook MEM_IoHook;
+typedef struct MEM_Watchpoint MEM_Watchpoint;
+typedef struct MEM_WatchHit MEM_WatchHit;
+typedef struct MEM_Stats MEM_Stats;
+
 #include "cartridge.h"
+#include "rom.h"
+#include "save.h"
+
+struct MEM_IoHook {
+    MEM_IoReadHook read;
+    MEM_IoWriteHook write;
+    void* context; // passed back to the hooks, usually the owning component
+};
+
+#define MEM_MAX_EXTRAM_BANKS 16
+#define MEM_MAX_WATCHPOINTS 16
+#define MEM_WATCH_HISTORY 256
+
+typedef enum MEM_WatchAccess {
+    MEM_WATCH_READ = 0x1,
+    MEM_WATCH_WRITE = 0x2,
+    MEM_WATCH_EXECUTE = 0x4
+} MEM_WatchAccess;
+
+struct MEM_Watchpoint {
+    uint16_t start;
+    uint16_t end;   // inclusive
+    int bank;       // ROM/external RAM bank the address has to be in, -1 for any bank
+    uint8_t access; // MEM_WatchAccess flags
+    bool pause;     // ask for emulation to stop on a hit
+};
+
+struct MEM_WatchHit {
+    uint64_t cycle;
+    uint16_t address;
+    uint16_t pc;
+    int bank;
+    MEM_WatchAccess access;
+    uint8_t oldValue;
+    uint8_t newValue; // same as oldValue for reads and executes
+};
+
+typedef enum MEM_Region {
+    MEM_REGION_ROM0,
+    MEM_REGION_ROMN,
+    MEM_REGION_VRAM,
+    MEM_REGION_EXTRAM,
+    MEM_REGION_WRAM, // including echo RAM
+    MEM_REGION_OAM,  // including the unusable area
+    MEM_REGION_IO,
+    MEM_REGION_HRAM, // including IE
+    MEM_REGIONS
+} MEM_Region;
+
+// Access counters, cumulative since MEM_enableStats. Opcode fetches are not counted, only data accesses.
+struct MEM_Stats {
+    uint64_t reads[MEM_REGIONS];
+    uint64_t writes[MEM_REGIONS];
+    uint64_t ioReads[0x80];  // per I/O register (0xFF00-0xFF7F)
+    uint64_t ioWrites[0x80];
+    uint64_t romBankSwitches; // MEM_setRomBank calls
+    uint64_t ramBankSwitches; // MEM_setRamBank calls
+
+    // Page tables as they would be published without the counting overlay, which the counting handlers forward to
+    const uint8_t* readPages[0x100];
+    MEM_ReadHandler readHandlers[0x100];
+    uint8_t* writePages[0x100];
+    MEM_WriteHandler writeHandlers[0x100];
+};
+
+#define MEM_CACHE_LINE 64
 
 struct Memory {
-    // Fixed memory regions (note: regions marked with _padding_ are not written to - sepatate pointers are used below)
+    // Hot block: the memory the CPU and GPU touch on every frame, contiguous and starting on a cache line.
+    // ROM and external RAM live outside the instance (see romBanks/extRamBanks), echo RAM is served by a handler.
+    _Alignas(MEM_CACHE_LINE) uint8_t videoRam[0x2000];
+    uint8_t workRam[0x2000];
     union {
         struct {
-            uint8_t _padding_romBank0[0x4000];
-            uint8_t _padding_romBankN[0x4000];
-            uint8_t videoRam[0x2000];
-            uint8_t _padding_extRam[0x2000];
-            uint8_t workRamBank0[0x1000];
-            uint8_t workRamBank1[0x1000];
-            uint8_t echoRam[0x1E00];
             uint8_t spriteAttributeTable[0x00A0];
             uint8_t unusable[0x0060];
+        };
+        uint8_t spritePage[0x100];
+    };
+    union {
+        struct {
             uint8_t ioRegisters[0x0080];
             uint8_t highRam[0x007F];
             uint8_t IE;
         };
-        uint8_t logicalMemory[0x10000];
+        uint8_t highPage[0x100];
     };
-    
+
+    // Read page table (one entry per 256-byte page). A non-NULL entry is the host address of the page; a NULL entry
+    // marks a special page (I/O, disabled external RAM, echo RAM) whose reads go through readHandlers instead.
+    _Alignas(MEM_CACHE_LINE) const uint8_t* readPages[0x100];
+    MEM_ReadHandler readHandlers[0x100];
+
+    // Write page table. Plain RAM pages point straight at their backing store; ROM (MBC registers), VRAM, disabled
+    // external RAM, echo RAM, OAM and the I/O page are NULL and go through their region's entry in writeHandlers.
+    uint8_t* writePages[0x100];
+    MEM_WriteHandler writeHandlers[0x100];
+
+    // Opcode fetch page table: the read page table, minus pages with execute watchpoints
+    const uint8_t* fetchPages[0x100];
+
+    // I/O register hooks (0xFF00-0xFF7F), so components are told about register writes as they happen and can
+    // compute register reads lazily. Registers without hooks behave as plain memory.
+    MEM_IoHook ioHooks[0x80];
+
+    // Bus clock in machine cycles, advanced by the CPU
+    uint64_t cycles;
+
+    // OAM DMA: the CPU is locked out of everything but the I/O page and HRAM until dmaEndCycle
+    bool dmaActive;
+    uint64_t dmaEndCycle;
+
+    // Dirty bits for the renderer's tile cache, one per tile (0x8000-0x97FF). Set by every write that changes tile
+    // data, cleared by the renderer once it has decoded the tile again.
+    uint64_t videoTileDirty[384 / 64];
+
     // Switchable banks
-    uint8_t* romBank0;
-    uint8_t* romBankN;
+    const uint8_t* romBank0;
+    const uint8_t* romBankN;
     uint8_t* extRam;
 
-    uint8_t* romBanks;
+    // Everything below is only touched when the memory map changes or while debugging
+
+    // Page tables as laid out by the memory map. The tables above are published from these with the overlays
+    // applied (OAM DMA lockout, watchpoint traps), so bank switches never have to know about the overlays.
+    _Alignas(MEM_CACHE_LINE) const uint8_t* baseReadPages[0x100];
+    MEM_ReadHandler baseReadHandlers[0x100];
+    uint8_t* baseWritePages[0x100];
+    MEM_WriteHandler baseWriteHandlers[0x100];
+
+    RomImage* rom;
+    const uint8_t* romBanks;
     int romBanksNo;
     uint8_t* extRamBanks;
     int extRamBanksNo;
+    bool extRamPlaced; // extRamBanks is storage provided by the caller (MEM_placeExtRam), not freed with the memory
     bool extRamEnabled;
-    Cartridge* cartridge; // TODO: should this be separated from memory?
+    Cartridge* cartridge; // NULL until a ROM is loaded, then cartridgeData TODO: should this be separated from memory?
+    Cartridge cartridgeData;
+
+    SaveFile* save; // NULL unless the cartridge has battery-backed RAM, then saveData
+    SaveFile saveData;
+
+    // Watchpoints trap the pages they cover, accesses to any other page run at full speed
+    MEM_Watchpoint watchpoints[MEM_MAX_WATCHPOINTS];
+    int watchpointsNo;
+    uint8_t watchedPages[0x100]; // MEM_WatchAccess flags of the watchpoints covering each page
+    MEM_WatchHit* watchHits;     // ring buffer of the MEM_WATCH_HISTORY most recent hits, allocated with the first watchpoint
+    uint64_t watchHitsNo;        // hits so far, the latest one is watchHits[(watchHitsNo - 1) % MEM_WATCH_HISTORY]
+    bool watchPaused;            // a pausing watchpoint was hit, cleared by whoever resumes emulation
+    const uint16_t* watchPc;     // program counter recorded with hits (NULL records 0)
 
-    int battery;
-    char* romPath;
+    MEM_Stats* stats; // NULL unless access statistics are enabled, every data access is trapped while they are
 
-    int dmaInProgress;
-    uint8_t dmaAddressUpper;
-    uint8_t dmaPosition;
+    // Copy-on-write sharing with a snapshot (see MEM_fork). Work RAM and external RAM pages the instance has not
+    // written to yet are read straight from the snapshot, the first write to a page copies it over.
+    const Memory* cowSource;   // NULL unless the instance is a fork
+    uint32_t cowWorkRamOwned;  // one bit per work RAM page that has been copied
+    uint64_t cowExtRamOwned[MEM_MAX_EXTRAM_BANKS * 0x2000 / 0x100 / 64]; // one bit per external RAM page (all banks) that has been copied
 };
 
 void MEM_init(Memory* mem);
 void MEM_destroy(Memory* mem);
-uint8_t MEM_getByte(Memory* mem, uint16_t address);
-void MEM_setByte(Memory* mem, uint16_t address, uint8_t value);
+void MEM_release(Memory* mem);
+void MEM_reset(Memory* mem);
+void MEM_setIoHook(Memory* mem, uint16_t address, MEM_IoReadHook read, MEM_IoWriteHook write, void* context);
+void MEM_retargetIoHooks(Memory* mem, const void* oldContext, void* newContext);
 void MEM_forceSetByte(Memory* mem, uint16_t address, uint8_t value);
 void MEM_pushToStack(Memory* mem, uint16_t* SP, uint16_t value);
 uint16_t MEM_popFromStack(Memory* mem, uint16_t* SP);
-void MEM_loadROM(Memory* mem, const char* path);
+void MEM_loadROM(Memory* mem, const char* path, SaveMode saveMode, IOWorker* io);
 void MEM_setRomBank(Memory* mem, uint8_t bankNo);
 void MEM_setRamBank(Memory* mem, uint8_t bankNo);
+void MEM_setRamEnabled(Memory* mem, bool enabled);
+void MEM_syncSave(Memory* mem);
+size_t MEM_getPlainExtRamSize(const Memory* mem);
+void MEM_placeExtRam(Memory* mem, uint8_t* storage);
 void MEM_dmaBegin(Memory* mem, uint8_t addressUpper);
-void MEM_dmaUpdate(Memory* mem);
+bool MEM_addWatchpoint(Memory* mem, MEM_Watchpoint watchpoint);
+void MEM_clearWatchpoints(Memory* mem);
+uint8_t MEM_fetchWatched(Memory* mem, uint16_t address);
+void MEM_enableStats(Memory* mem);
+MEM_Region MEM_getRegion(uint16_t address);
+void MEM_snapshot(Memory* snapshot, Memory* mem);
+void MEM_fork(Memory* child, const Memory* snapshot, uint8_t* extRamStorage);
+
+static inline uint8_t MEM_getByte(Memory* mem, uint16_t address) {
+    const uint8_t* page = mem->readPages[address >> 8];
+    return page != NULL
+        ? page[address & 0xFF]
+        : mem->readHandlers[address >> 8](mem, address);
+}
+
+static inline void MEM_setByte(Memory* mem, uint16_t address, uint8_t value) {
+    uint8_t* page = mem->writePages[address >> 8];
+    if (page != NULL) {
+        page[address & 0xFF] = value;
+    } else {
+        mem->writeHandlers[address >> 8](mem, address, value);
+    }
+}
+
+// 16-bit little-endian accesses. When both bytes are in the same directly mapped page (plain RAM or ROM) this is a
+// single unaligned host access, anything else falls back to two byte accesses.
+static inline uint16_t MEM_getWord(Memory* mem, uint16_t address) {
+    const uint8_t* page = mem->readPages[address >> 8];
+    if (page != NULL && (address & 0xFF) != 0xFF) {
+        uint16_t value;
+        memcpy(&value, page + (address & 0xFF), sizeof(value));
+        #if ENDIANNESS == BIG_E
+        value = (value << 8) | (value >> 8);
+        #endif
+        return value;
+    }
+    return MEM_getByte(mem, address) | (MEM_getByte(mem, address + 1) << 8);
+}
+
+// The byte fallback writes the low byte first, the order LD (nn),SP uses. Stack pushes write the high byte first and
+// go through MEM_pushToStack instead.
+static inline void MEM_setWord(Memory* mem, uint16_t address, uint16_t value) {
+    uint8_t* page = mem->writePages[address >> 8];
+    if (page != NULL && (address & 0xFF) != 0xFF) {
+        #if ENDIANNESS == BIG_E
+        value = (value << 8) | (value >> 8);
+        #endif
+        memcpy(page + (address & 0xFF), &value, sizeof(value));
+    } else {
+        MEM_setByte(mem, address, value & 0xFF);
+        MEM_setByte(mem, address + 1, value >> 8);
+    }
+}
+
+// Opcode fetch: a read that triggers execute watchpoints instead of read watchpoints
+static inline uint8_t MEM_fetchOpcode(Memory* mem, uint16_t address) {
+    const uint8_t* page = mem->fetchPages[address >> 8];
+    return page != NULL
+        ? page[address & 0xFF]
+        : MEM_fetchWatched(mem, address);
+}
+
+// Tile number counted from 0x8000 (0-383)
+static inline bool MEM_isTileDirty(const Memory* mem, int tile) {
+    return (mem->videoTileDirty[tile / 64] >> (tile % 64)) & 1;
+}
+
+static inline void MEM_clearTileDirty(Memory* mem, int tile) {
+    mem->videoTileDirty[tile / 64] &= ~(UINT64_C(1) << (tile % 64));
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#define _GNU_SOURCE // MAP_ANONYMOUS, syscall
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "region.h"
+
+#ifndef MPOL_PREFERRED
+    #define MPOL_PREFERRED 1
+#endif
+
+static bool mapLocalHugePages(Region* region, size_t size);
+
+// Set up a zeroed region of at least size bytes. Pages are only allocated once they are written, so space reserved
+// for the largest case (such as external RAM) costs nothing when it goes unused. With localHugePages, the region is
+// backed by transparent huge pages on the NUMA node of the calling thread (which should be the thread that runs the
+// instance) and faulted in up front.
+bool REGION_init(Region* region, size_t size, bool localHugePages) {
+    region->used = 0;
+    if (localHugePages && mapLocalHugePages(region, size)) {
+        return true;
+    }
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        perror("Error while mapping instance memory");
+        return false;
+    }
+    region->base = base;
+    region->size = size;
+    return true;
+}
+
+void REGION_destroy(Region* region) {
+    munmap(region->base, region->size);
+    region->base = NULL;
+}
+
+// Carve an allocation out of the region (NULL if it does not fit). alignment must be a power of two.
+void* REGION_alloc(Region* region, size_t size, size_t alignment) {
+    size_t start = (region->used + alignment - 1) & ~(alignment - 1);
+    if (start > region->size || region->size - start < size) return NULL;
+
+    region->used = start + size;
+    return region->base + start;
+}
+
+static bool mapLocalHugePages(Region* region, size_t size) {
+    // Map a huge page more than needed so the region can start on a huge page boundary
+    size = (size + REGION_HUGE_PAGE_SIZE - 1) & ~(REGION_HUGE_PAGE_SIZE - 1);
+    uint8_t* mapping = mmap(NULL, size + REGION_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Error while mapping instance memory");
+        return false;
+    }
+    uint8_t* base = (uint8_t*) (((uintptr_t) mapping + REGION_HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (REGION_HUGE_PAGE_SIZE - 1));
+    if (base != mapping) munmap(mapping, base - mapping);
+    munmap(base + size, mapping + REGION_HUGE_PAGE_SIZE - base);
+
+    // Both are hints: without THP or NUMA support the region still works, just with small or remote pages
+    madvise(base, size, MADV_HUGEPAGE);
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0 && node < 8 * sizeof(unsigned long)) {
+        // The kernel ignores the last bit of maxnode, so pass one more than the bits in the mask to cover node 63
+        unsigned long nodeMask = 1UL << node;
+        syscall(SYS_mbind, base, size, MPOL_PREFERRED, &nodeMask, (8 * sizeof(nodeMask)) + 1, 0);
+    }
+
+    // Fault the pages in from this thread, so they are allocated now and on this node
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        base[offset] = 0;
+    }
+
+    region->base = base;
+    region->size = size;
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef REGION_H
+#define REGION_H
+
+typedef struct Region Region;
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A block of memory the state of one instance is carved out of. Allocations are only freed all at once.
+struct Region {
+    uint8_t* base; // anonymous mapping, zero until written
+    size_t size;
+    size_t used;
+};
+
+#define REGION_HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+bool REGION_init(Region* region, size_t size, bool localHugePages);
+void REGION_destroy(Region* region);
+void* REGION_alloc(Region* region, size_t size, size_t alignment);
+
+#endif
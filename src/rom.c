@@ -0,0 +1,412 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "inflate.h"
+#include "rom.h"
+
+// Open images, shared between instances
+static RomImage* openImages = NULL;
+static pthread_mutex_t openImagesLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Slice-by-8 tables for the portable CRC-32C
+static uint32_t crc32cTable[8][256];
+static pthread_once_t crc32cTableOnce = PTHREAD_ONCE_INIT;
+
+static RomImage* findImage(const struct stat* info);
+static bool mapImage(RomImage* rom, int fd, const struct stat* info);
+static bool readImage(RomImage* rom, int fd);
+static bool decompressImage(RomImage* rom);
+static bool inflateGzip(const uint8_t* data, size_t size, InflateOutput* out);
+static bool inflateZip(const uint8_t* data, size_t size, InflateOutput* out);
+static bool hasExtension(const char* name, size_t length, const char* extension);
+static size_t nextRomCapacity(const InflateOutput* out);
+static void releaseImage(RomImage* rom);
+static uint32_t readLe32(const uint8_t* data);
+static uint16_t readLe16(const uint8_t* data);
+static uint32_t crc32cPortable(uint32_t crc, const uint8_t* data, size_t size);
+static void buildCrc32cTable(void);
+#if defined(__x86_64__) && defined(__GNUC__)
+static uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t size);
+#endif
+
+// Open a ROM image, reusing an already open image of the same file if there is one. gzip files and zip archives are
+// decompressed on the fly.
+RomImage* ROM_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Error while opening ROM");
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        perror("Error while opening ROM");
+        close(fd);
+        return NULL;
+    }
+
+    // Reuse the image if this file (unchanged) is already open
+    bool shareable = S_ISREG(info.st_mode);
+    if (shareable) {
+        pthread_mutex_lock(&openImagesLock);
+        RomImage* rom = findImage(&info);
+        pthread_mutex_unlock(&openImagesLock);
+        if (rom != NULL) {
+            close(fd);
+            return rom;
+        }
+    }
+
+    // Load, decompress and hash without holding the lock, so instances starting on other threads are not held up
+    RomImage* rom = calloc(1, sizeof(*rom)); // freed in ROM_close
+    bool loaded = rom != NULL && (mapImage(rom, fd, &info) || readImage(rom, fd));
+    close(fd);
+    if (loaded && !decompressImage(rom)) {
+        releaseImage(rom);
+        loaded = false;
+    }
+    if (!loaded) {
+        free(rom);
+        return NULL;
+    }
+    rom->hash = ROM_crc32c(rom->data, rom->size);
+
+    // Another thread may have opened the same file in the meantime, in which case its image wins
+    pthread_mutex_lock(&openImagesLock);
+    RomImage* existing = shareable ? findImage(&info) : NULL;
+    if (existing != NULL) {
+        pthread_mutex_unlock(&openImagesLock);
+        releaseImage(rom);
+        free(rom);
+        return existing;
+    }
+
+    rom->shareable = shareable;
+    rom->device = info.st_dev;
+    rom->inode = info.st_ino;
+    rom->fileSize = info.st_size;
+    rom->modified = info.st_mtim;
+    rom->refCount = 1;
+    rom->next = openImages;
+    openImages = rom;
+    pthread_mutex_unlock(&openImagesLock);
+    return rom;
+}
+
+// Open image of a file (unchanged since it was opened), with a new reference taken. The caller holds openImagesLock.
+static RomImage* findImage(const struct stat* info) {
+    for (RomImage* rom = openImages; rom != NULL; rom = rom->next) {
+        if (rom->shareable && rom->device == info->st_dev && rom->inode == info->st_ino
+            && rom->fileSize == info->st_size
+            && rom->modified.tv_sec == info->st_mtim.tv_sec && rom->modified.tv_nsec == info->st_mtim.tv_nsec) {
+            ++(rom->refCount);
+            return rom;
+        }
+    }
+    return NULL;
+}
+
+// Take another reference to an open image (NULL is ignored)
+void ROM_retain(RomImage* rom) {
+    if (rom == NULL) return;
+
+    pthread_mutex_lock(&openImagesLock);
+    ++(rom->refCount);
+    pthread_mutex_unlock(&openImagesLock);
+}
+
+// Release a ROM image, unmapping/freeing it once no instance uses it
+void ROM_close(RomImage* rom) {
+    if (rom == NULL) return;
+
+    pthread_mutex_lock(&openImagesLock);
+    if (--(rom->refCount) > 0) {
+        pthread_mutex_unlock(&openImagesLock);
+        return;
+    }
+    for (RomImage** link = &openImages; *link != NULL; link = &((*link)->next)) {
+        if (*link == rom) {
+            *link = rom->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&openImagesLock);
+
+    releaseImage(rom);
+    free(rom);
+}
+
+// Map a regular file read-only so the page cache backs it
+static bool mapImage(RomImage* rom, int fd, const struct stat* info) {
+    if (!S_ISREG(info->st_mode) || info->st_size <= 0) return false;
+
+    void* data = mmap(NULL, info->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    rom->data = data;
+    rom->size = info->st_size;
+    rom->mapped = true;
+    return true;
+}
+
+// Fallback for files that cannot be mapped (pipes, special files, ...): copy the contents to the heap
+static bool readImage(RomImage* rom, int fd) {
+    size_t capacity = 0x8000, size = 0;
+    uint8_t* data = malloc(capacity);
+
+    while (data != NULL) {
+        if (size == capacity) {
+            uint8_t* grown = realloc(data, capacity * 2);
+            if (grown == NULL) break;
+            data = grown;
+            capacity *= 2;
+        }
+
+        ssize_t count = read(fd, data + size, capacity - size);
+        if (count == 0) {
+            rom->data = data;
+            rom->size = size;
+            rom->mapped = false;
+            return true;
+        }
+        if (count < 0 && errno != EINTR) {
+            perror("Error while reading ROM");
+            break;
+        }
+        if (count > 0) size += count;
+    }
+
+    free(data);
+    return false;
+}
+
+// CRC-32C (Castagnoli), with the SSE4.2 instruction when the CPU has it
+uint32_t ROM_crc32c(const uint8_t* data, size_t size) {
+    #if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ~crc32cSse42(~UINT32_C(0), data, size);
+    }
+    #endif
+    return ~crc32cPortable(~UINT32_C(0), data, size);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t size) {
+    uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+    crc = crc64;
+    for (; size > 0; ++data, --size) {
+        crc = __builtin_ia32_crc32qi(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+static uint32_t crc32cPortable(uint32_t crc, const uint8_t* data, size_t size) {
+    pthread_once(&crc32cTableOnce, buildCrc32cTable);
+
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t low = crc ^ readLe32(data);
+        uint32_t high = readLe32(data + 4);
+        crc = crc32cTable[7][low & 0xFF] ^ crc32cTable[6][(low >> 8) & 0xFF]
+            ^ crc32cTable[5][(low >> 16) & 0xFF] ^ crc32cTable[4][low >> 24]
+            ^ crc32cTable[3][high & 0xFF] ^ crc32cTable[2][(high >> 8) & 0xFF]
+            ^ crc32cTable[1][(high >> 16) & 0xFF] ^ crc32cTable[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size) {
+        crc = crc32cTable[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void buildCrc32cTable(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+        }
+        crc32cTable[0][i] = crc;
+    }
+    for (int slice = 1; slice < 8; ++slice) {
+        for (int i = 0; i < 256; ++i) {
+            uint32_t previous = crc32cTable[slice - 1][i];
+            crc32cTable[slice][i] = (previous >> 8) ^ crc32cTable[0][previous & 0xFF];
+        }
+    }
+}
+
+// Replace a compressed image with its contents. Raw images are left alone.
+static bool decompressImage(RomImage* rom) {
+    bool gzip = rom->size >= 2 && rom->data[0] == 0x1F && rom->data[1] == 0x8B;
+    bool zip = rom->size >= 4 && memcmp(rom->data, "PK\x03\x04", 4) == 0;
+    if (!gzip && !zip) return true;
+
+    // The ROM is inflated straight into its final buffer, grown to the size the cartridge header declares. Anything
+    // that inflates to more than the largest valid ROM is rejected rather than allowed to exhaust memory.
+    InflateOutput out = {malloc(0x8000), 0, 0x8000, nextRomCapacity, ROM_MAX_SIZE};
+    if (out.data == NULL || !(gzip ? inflateGzip(rom->data, rom->size, &out) : inflateZip(rom->data, rom->size, &out))) {
+        free(out.data);
+        return false;
+    }
+
+    releaseImage(rom);
+    rom->data = out.data;
+    rom->size = out.size;
+    rom->mapped = false;
+    return true;
+}
+
+// gzip file (RFC 1952) holding a single member
+static bool inflateGzip(const uint8_t* data, size_t size, InflateOutput* out) {
+    if (size < 18 || data[2] != 8) {
+        fprintf(stderr, "Invalid ROM: unsupported gzip file\n");
+        return false;
+    }
+
+    // Skip the optional header fields: extra data, file name, comment, header CRC
+    uint8_t flags = data[3];
+    size_t pos = 10;
+    if (flags & 0x04) pos += 2 + readLe16(data + pos);
+    for (int field = 0x08; field <= 0x10; field <<= 1) {
+        if (flags & field) {
+            while (pos < size && data[pos] != 0) ++pos;
+            ++pos;
+        }
+    }
+    if (flags & 0x02) pos += 2;
+
+    size_t consumed;
+    if (pos >= size || !INF_inflate(data + pos, size - pos, &consumed, out) || size - pos - consumed < 8) {
+        fprintf(stderr, "Invalid ROM: corrupt gzip file (or larger than any ROM)\n");
+        return false;
+    }
+    pos += consumed;
+    if (readLe32(data + pos) != INF_crc32(out->data, out->size) || readLe32(data + pos + 4) != (uint32_t) out->size) {
+        fprintf(stderr, "Invalid ROM: gzip checksum mismatch\n");
+        return false;
+    }
+    return true;
+}
+
+// zip archive: the first member named *.gb, *.gbc or *.sgb (or else the first file), stored or deflated
+static bool inflateZip(const uint8_t* data, size_t size, InflateOutput* out) {
+    // Find the end of central directory record, which may be followed by a comment of up to 64 KiB
+    const uint8_t* end = NULL;
+    if (size >= 22) {
+        size_t first = size - 22 > 0xFFFF ? size - 22 - 0xFFFF : 0;
+        for (size_t pos = size - 22 + 1; pos-- > first;) {
+            if (memcmp(data + pos, "PK\x05\x06", 4) == 0) {
+                end = data + pos;
+                break;
+            }
+        }
+    }
+    if (end == NULL) {
+        fprintf(stderr, "Invalid ROM: corrupt zip archive\n");
+        return false;
+    }
+
+    // Pick a member from the central directory
+    const uint8_t* member = NULL;
+    size_t pos = readLe32(end + 16);
+    for (int i = readLe16(end + 10); i > 0; --i) {
+        if (pos > size || size - pos < 46 || memcmp(data + pos, "PK\x01\x02", 4) != 0) break;
+        const uint8_t* entry = data + pos;
+        size_t nameLength = readLe16(entry + 28);
+        pos += 46 + nameLength + readLe16(entry + 30) + readLe16(entry + 32);
+        if (pos > size || nameLength == 0 || entry[46 + nameLength - 1] == '/') continue;
+
+        const char* name = (const char*) entry + 46;
+        bool rom = hasExtension(name, nameLength, "gb") || hasExtension(name, nameLength, "gbc")
+            || hasExtension(name, nameLength, "sgb");
+        if (member == NULL || rom) member = entry;
+        if (rom) break;
+    }
+    if (member == NULL) {
+        fprintf(stderr, "Invalid ROM: no file in zip archive\n");
+        return false;
+    }
+
+    // Member data follows its local header
+    uint16_t method = readLe16(member + 10);
+    size_t compressedSize = readLe32(member + 20);
+    size_t uncompressedSize = readLe32(member + 24);
+    size_t local = readLe32(member + 42);
+    if (local > size || size - local < 30 || memcmp(data + local, "PK\x03\x04", 4) != 0) {
+        fprintf(stderr, "Invalid ROM: corrupt zip archive\n");
+        return false;
+    }
+    size_t start = local + 30 + readLe16(data + local + 26) + readLe16(data + local + 28);
+    if (start > size || size - start < compressedSize) {
+        fprintf(stderr, "Invalid ROM: corrupt zip archive\n");
+        return false;
+    }
+
+    size_t consumed;
+    if (uncompressedSize > ROM_MAX_SIZE || (method == 0 && compressedSize > ROM_MAX_SIZE)) {
+        fprintf(stderr, "Invalid ROM: zip member is larger than any ROM\n");
+        return false;
+    } else if (method == 0) {
+        uint8_t* copy = realloc(out->data, compressedSize > 0 ? compressedSize : 1);
+        if (copy == NULL) return false;
+        memcpy(copy, data + start, compressedSize);
+        out->data = copy;
+        out->size = out->capacity = compressedSize;
+    } else if (method != 8) {
+        fprintf(stderr, "Invalid ROM: unsupported zip compression method %u\n", method);
+        return false;
+    } else if (!INF_inflate(data + start, compressedSize, &consumed, out)) {
+        fprintf(stderr, "Invalid ROM: corrupt zip archive\n");
+        return false;
+    }
+    if (out->size != uncompressedSize || INF_crc32(out->data, out->size) != readLe32(member + 16)) {
+        fprintf(stderr, "Invalid ROM: zip checksum mismatch\n");
+        return false;
+    }
+    return true;
+}
+
+// File name (not NUL-terminated) ending in .<extension>, ignoring case
+static bool hasExtension(const char* name, size_t length, const char* extension) {
+    size_t extensionLength = strlen(extension);
+    return length > extensionLength && name[length - extensionLength - 1] == '.'
+        && strncasecmp(name + length - extensionLength, extension, extensionLength) == 0;
+}
+
+// Grow a ROM being decompressed to the size declared by its header (0x148) once that is known, doubling otherwise
+static size_t nextRomCapacity(const InflateOutput* out) {
+    if (out->size > 0x148 && out->data[0x148] <= 8 && ((size_t) 0x8000 << out->data[0x148]) > out->capacity) {
+        return (size_t) 0x8000 << out->data[0x148];
+    }
+    return out->capacity * 2;
+}
+
+static void releaseImage(RomImage* rom) {
+    if (rom->mapped) {
+        munmap((void*) rom->data, rom->size);
+    } else {
+        free((void*) rom->data);
+    }
+    rom->data = NULL;
+}
+
+static uint32_t readLe32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static uint16_t readLe16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
@@ -0,0 +1,37 @@
+#ifndef ROM_H
+#define ROM_H
+
+typedef struct RomImage RomImage;
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define ROM_MAX_SIZE ((size_t) 0x8000 << 8) // largest ROM a cartridge header can declare (8 MiB)
+
+// A read-only ROM image. Images opened from the same file are shared by every instance in the process.
+struct RomImage {
+    const uint8_t* data;
+    size_t size;
+    bool mapped; // data is a read-only mapping of the file rather than a heap copy
+    uint32_t hash; // CRC-32C of the (decompressed) contents, identifies the ROM for caches, saves and settings
+
+    // Identity of the backing file, used to find an existing image (only set for shareable images)
+    bool shareable;
+    dev_t device;
+    ino_t inode;
+    off_t fileSize;
+    struct timespec modified;
+
+    int refCount;
+    RomImage* next;
+};
+
+RomImage* ROM_open(const char* path);
+void ROM_retain(RomImage* rom);
+uint32_t ROM_crc32c(const uint8_t* data, size_t size);
+void ROM_close(RomImage* rom);
+
+#endif
@@ -0,0 +1,242 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "io.h"
+#include "save.h"
+
+// Battery RAM as of a save, handed to the I/O thread
+typedef struct PageWrite {
+    SaveFile* save;
+    uint8_t* data;
+    uint64_t* dirty;
+} PageWrite;
+
+static bool mapSave(SaveFile* save);
+static bool loadSave(SaveFile* save);
+static PageWrite* snapshotDirtyPages(SaveFile* save);
+static void freePageWrite(PageWrite* write);
+static void syncMapping(void* context);
+static void writeDirtyPages(void* context);
+static bool isPageOutdated(const PageWrite* write, size_t page);
+
+// Open the save file for a ROM and return the battery RAM buffer backed by it (NULL on failure)
+uint8_t* SAVE_open(SaveFile* save, const char* romPath, size_t size, SaveMode mode, IOWorker* io) {
+    save->mode = mode;
+    save->io = io;
+    save->size = size;
+    save->data = NULL;
+    save->path = malloc(strlen(romPath) + 5); // freed in SAVE_close
+    snprintf(save->path, strlen(romPath) + 5, "%s.sav", romPath);
+    save->tmpPath = NULL;
+    save->dirty = NULL;
+    save->tmpStale = NULL;
+    atomic_init(&(save->failed), false);
+    save->lastBytesWritten = 0;
+    save->totalBytesWritten = 0;
+    save->savesWritten = 0;
+
+    if (save->mode == SAVE_MAPPED && !mapSave(save)) {
+        fprintf(stderr, "Could not map %s, saving on exit instead\n", save->path);
+        save->mode = SAVE_ON_EXIT;
+    }
+    if (save->mode != SAVE_MAPPED && !loadSave(save)) {
+        free(save->path);
+        save->path = NULL;
+        return NULL;
+    }
+
+    if (save->mode == SAVE_INCREMENTAL) {
+        size_t words = (save->size / SAVE_PAGE_SIZE + 63) / 64;
+        save->tmpPath = malloc(strlen(save->path) + 5); // freed in SAVE_close
+        snprintf(save->tmpPath, strlen(save->path) + 5, "%s.tmp", save->path);
+        save->dirty = calloc(words, sizeof(*save->dirty)); // freed in SAVE_close
+        save->tmpStale = malloc(words * sizeof(*save->tmpStale)); // freed in SAVE_close
+        // Nothing is known about a leftover temp file, so it has to be written in full the first time
+        memset(save->tmpStale, 0xFF, words * sizeof(*save->tmpStale));
+    }
+
+    return save->data;
+}
+
+// Queue a flush of battery RAM to the save file (no effect for saves written on exit).
+// Never waits for the disk: if the I/O queue is full, the pages stay dirty for the next save.
+void SAVE_sync(SaveFile* save) {
+    if (save->mode == SAVE_MAPPED) {
+        IO_trySubmit(save->io, syncMapping, save);
+
+    } else if (save->mode == SAVE_INCREMENTAL) {
+        PageWrite* write = snapshotDirtyPages(save);
+        if (write == NULL) return;
+        if (IO_trySubmit(save->io, writeDirtyPages, write)) {
+            memset(save->dirty, 0, (save->size / SAVE_PAGE_SIZE + 63) / 64 * sizeof(*save->dirty));
+        } else {
+            // Keep a pending retry of a failed save, which may have nothing marked dirty left to bring it back
+            atomic_store(&(save->failed), true);
+            freePageWrite(write);
+        }
+    }
+}
+
+// Write out (or unmap) battery RAM and release it, waiting for pending saves
+void SAVE_close(SaveFile* save) {
+    if (save->mode == SAVE_MAPPED) {
+        IO_flush(save->io);
+        msync(save->data, save->size, MS_SYNC);
+        munmap(save->data, save->size);
+
+    } else if (save->mode == SAVE_INCREMENTAL) {
+        // Let queued saves finish first, then write what is left. A final save that fails gets one more try.
+        IO_flush(save->io);
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            PageWrite* write = snapshotDirtyPages(save);
+            if (write == NULL) break;
+            IO_submit(save->io, writeDirtyPages, write);
+            IO_flush(save->io);
+        }
+        printf("[SAVE] %u saves, %llu bytes written in total\n", save->savesWritten, (unsigned long long) save->totalBytesWritten);
+
+        free(save->data);
+        free(save->dirty);
+        free(save->tmpStale);
+        free(save->tmpPath);
+        save->dirty = NULL;
+        save->tmpStale = NULL;
+        save->tmpPath = NULL;
+
+    } else {
+        // The I/O thread takes over the buffer
+        IO_writeFile(save->io, save->path, save->data, save->size);
+    }
+
+    save->data = NULL;
+    free(save->path);
+    save->path = NULL;
+}
+
+// Map the save file (creating or growing it as needed), so every write to battery RAM lands in the page cache
+static bool mapSave(SaveFile* save) {
+    int fd = open(save->path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (info.st_size < (off_t) save->size && ftruncate(fd, save->size) != 0)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, save->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    save->data = data;
+    return true;
+}
+
+// Read the save file (if there is one) into a heap buffer
+static bool loadSave(SaveFile* save) {
+    save->data = calloc(save->size, 1); // freed in SAVE_close
+    if (save->data == NULL) return false;
+
+    FILE* file = fopen(save->path, "rb");
+    if (file != NULL) {
+        if (fread(save->data, 1, save->size, file) != save->size) {
+            fprintf(stderr, "Save file %s is shorter than the cartridge RAM\n", save->path);
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+// Copy battery RAM and the dirty page bitmap for a save (NULL if nothing changed and the last save went through).
+// Pages a failed save did not get to disk are still marked in tmpStale, so retrying writes them again.
+static PageWrite* snapshotDirtyPages(SaveFile* save) {
+    size_t bitmapSize = (save->size / SAVE_PAGE_SIZE + 63) / 64 * sizeof(*save->dirty);
+    bool dirty = atomic_exchange(&(save->failed), false);
+    for (size_t i = 0; i < bitmapSize / sizeof(*save->dirty); ++i) {
+        dirty = dirty || save->dirty[i] != 0;
+    }
+    if (!dirty) return NULL;
+
+    PageWrite* write = malloc(sizeof(*write)); // freed in writeDirtyPages
+    write->save = save;
+    write->data = malloc(save->size);
+    write->dirty = malloc(bitmapSize);
+    memcpy(write->data, save->data, save->size);
+    memcpy(write->dirty, save->dirty, bitmapSize);
+    return write;
+}
+
+static void freePageWrite(PageWrite* write) {
+    free(write->data);
+    free(write->dirty);
+    free(write);
+}
+
+// I/O thread: flush a mapped save (the context is the SaveFile itself, which outlives the job)
+static void syncMapping(void* context) {
+    SaveFile* save = context;
+    msync(save->data, save->size, MS_SYNC);
+}
+
+// I/O thread: write the pages changed since the last save to the temp file and atomically swap it with the save
+// file. Battery RAM is only ever replaced as a whole, so a crash mid-save leaves the previous save intact.
+static void writeDirtyPages(void* context) {
+    PageWrite* write = context;
+    SaveFile* save = write->save;
+    size_t pages = save->size / SAVE_PAGE_SIZE;
+    size_t bitmapSize = (pages + 63) / 64 * sizeof(*save->tmpStale);
+
+    // One pwrite per run of outdated pages
+    int fd = open(save->tmpPath, O_WRONLY | O_CREAT, 0644);
+    size_t written = 0;
+    bool ok = fd >= 0;
+    for (size_t page = 0; page < pages && ok;) {
+        if (!isPageOutdated(write, page)) {
+            ++page;
+            continue;
+        }
+        size_t first = page;
+        while (page < pages && isPageOutdated(write, page)) ++page;
+
+        size_t offset = first * SAVE_PAGE_SIZE;
+        size_t length = (page - first) * SAVE_PAGE_SIZE;
+        ok = IO_pwriteAll(fd, write->data + offset, length, offset);
+        written += length;
+    }
+    ok = ok && ftruncate(fd, save->size) == 0 && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+
+    if (ok && IO_exchangeFiles(save->tmpPath, save->path)) {
+        // The temp file now holds the previous save, which lags behind only in the pages just saved
+        memcpy(save->tmpStale, write->dirty, bitmapSize);
+    } else if (ok && rename(save->tmpPath, save->path) == 0) {
+        // No previous save (or no RENAME_EXCHANGE support): the next save starts a new temp file
+        memset(save->tmpStale, 0xFF, bitmapSize);
+    } else {
+        // The save file is untouched; a later save rewrites these pages from the temp file's point of view
+        perror("Error while writing save file");
+        for (size_t i = 0; i < bitmapSize / sizeof(*save->tmpStale); ++i) {
+            save->tmpStale[i] |= write->dirty[i];
+        }
+        atomic_store(&(save->failed), true);
+        freePageWrite(write);
+        return;
+    }
+    IO_syncDirectory(save->path);
+
+    save->lastBytesWritten = written;
+    save->totalBytesWritten += written;
+    ++(save->savesWritten);
+    printf("[SAVE] %zu bytes written to %s\n", written, save->path);
+    freePageWrite(write);
+}
+
+// A page has to be written if it changed since the last save or the temp file missed an earlier change to it
+static bool isPageOutdated(const PageWrite* write, size_t page) {
+    return ((write->dirty[page / 64] | write->save->tmpStale[page / 64]) >> (page % 64)) & 1;
+}
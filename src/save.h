@@ -0,0 +1,55 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+typedef struct SaveFile SaveFile;
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "io.h"
+
+typedef enum SaveMode {
+    SAVE_ON_EXIT,    // battery RAM lives on the heap and is written out when the instance is destroyed
+    SAVE_MAPPED,     // battery RAM is a shared mapping of the save file, flushed with msync
+    SAVE_INCREMENTAL // battery RAM lives on the heap, dirty pages are written to a temp file that replaces the save file
+} SaveMode;
+
+#define SAVE_PAGE_SIZE 0x100
+
+// Battery-backed external RAM and the .sav file behind it
+struct SaveFile {
+    SaveMode mode;
+    char* path;
+    uint8_t* data;
+    size_t size;
+    IOWorker* io; // writes happen on this thread
+
+    // Incremental saves only
+    char* tmpPath;
+    uint64_t* dirty; // pages written since the last save
+
+    // Owned by the I/O thread (only read elsewhere once SAVE_close has flushed it)
+    uint64_t* tmpStale; // pages in which the temp file differs from battery RAM as of the last save
+    atomic_bool failed; // the last save did not make it to disk, so the next one is written even if nothing changed
+    size_t lastBytesWritten;
+    uint64_t totalBytesWritten;
+    unsigned int savesWritten;
+};
+
+uint8_t* SAVE_open(SaveFile* save, const char* romPath, size_t size, SaveMode mode, IOWorker* io);
+void SAVE_sync(SaveFile* save);
+void SAVE_close(SaveFile* save);
+
+static inline bool SAVE_isPageDirty(const SaveFile* save, size_t offset) {
+    size_t page = offset / SAVE_PAGE_SIZE;
+    return (save->dirty[page / 64] >> (page % 64)) & 1;
+}
+
+static inline void SAVE_markPageDirty(SaveFile* save, size_t offset) {
+    size_t page = offset / SAVE_PAGE_SIZE;
+    save->dirty[page / 64] |= UINT64_C(1) << (page % 64);
+}
+
+#endif
@@ -8,21 +8,21 @@
 
 static void updateDiv(Memory* mem, Timer* timer);
 static void updateTima(Memory* mem, Timer* timer);
+static void writeDiv(void* context, Memory* mem, uint16_t address, uint8_t value);
+static void writeTac(void* context, Memory* mem, uint16_t address, uint8_t value);
 
-void TIMER_init(Timer* timer) {
+void TIMER_init(Timer* timer, Memory* mem) {
     timer->divCounter = 0;
-}
+    timer->timaCounter = 0;
+    timer->timaEnabled = false;
+    timer->timaInterval = 256;
 
-void TIMER_destroy(Timer* timer) {
-    free(timer);
-    timer = NULL;
+    MEM_setIoHook(mem, REG_DIV, NULL, writeDiv, timer);
+    MEM_setIoHook(mem, REG_TAC, NULL, writeTac, timer);
 }
 
 // Update the timer and divider registers
 void TIMER_update(CPU* cpu, Memory* mem, Timer* timer) {
-    uint8_t* TIMA = &(mem->logicalMemory[REG_TIMA]);
-    uint8_t TAC = mem->logicalMemory[REG_TAC];
-
     // Update DIV every 256 machine cycles
     if (timer->divCounter == 64) {//256) {
         timer->divCounter = 0;
@@ -32,23 +32,14 @@ void TIMER_update(CPU* cpu, Memory* mem, Timer* timer) {
     }
 
     // Update TIMA
-    if (!getBit(TAC, 2)) {
+    if (!timer->timaEnabled) {
         timer->timaCounter = 0;
-        *TIMA = 0;
         return;
     }
 
-    int interval = 0;
-    switch (TAC & 0x3) {
-        case 0: interval = 256; break;
-        case 1: interval = 4; break;
-        case 2: interval = 16; break;
-        case 3: interval = 64; break;
-    }
-
     //++(timer->timaCounter);
-    if (timer->timaCounter >= interval) {
-        timer->timaCounter = (timer->timaCounter - interval + 1);
+    if (timer->timaCounter >= timer->timaInterval) {
+        timer->timaCounter = (timer->timaCounter - timer->timaInterval + 1);
         updateTima(mem, timer);
     } else {
         ++(timer->timaCounter);
@@ -56,7 +47,7 @@ void TIMER_update(CPU* cpu, Memory* mem, Timer* timer) {
 }
 
 static void updateDiv(Memory* mem, Timer* timer) {
-    uint8_t* DIV = &(mem->logicalMemory[REG_DIV]);
+    uint8_t* DIV = &(mem->ioRegisters[REG_DIV - OFFSET_IOREGISTERS]);
     if (*DIV == 0) {
         timer->divCounter = 0;
     }
@@ -64,11 +55,31 @@ static void updateDiv(Memory* mem, Timer* timer) {
 }
 
 static void updateTima(Memory* mem, Timer* timer) {
-    uint8_t* TIMA = &(mem->logicalMemory[REG_TIMA]);
+    uint8_t* TIMA = &(mem->ioRegisters[REG_TIMA - OFFSET_IOREGISTERS]);
     if (*TIMA == 0xFF) {
-        *TIMA = mem->logicalMemory[REG_TMA];
-        mem->logicalMemory[REG_IF] |= 0x4;
+        *TIMA = mem->ioRegisters[REG_TMA - OFFSET_IOREGISTERS];
+        mem->ioRegisters[REG_IF - OFFSET_IOREGISTERS] |= 0x4;
     } else {
         ++*TIMA;
     }
+}
+
+// Writing any value to DIV resets it
+static void writeDiv(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    mem->ioRegisters[REG_DIV - OFFSET_IOREGISTERS] = 0;
+}
+
+static void writeTac(void* context, Memory* mem, uint16_t address, uint8_t value) {
+    Timer* timer = context;
+
+    // Preserve last 3 bits only (set rest to 1)
+    mem->ioRegisters[REG_TAC - OFFSET_IOREGISTERS] = 0xF8 | (value & 0x7);
+
+    timer->timaEnabled = getBit(value, 2);
+    switch (value & 0x3) {
+        case 0: timer->timaInterval = 256; break;
+        case 1: timer->timaInterval = 4; break;
+        case 2: timer->timaInterval = 16; break;
+        case 3: timer->timaInterval = 64; break;
+    }
 }
\ No newline at end of file
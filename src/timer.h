@@ -3,6 +3,7 @@
 
 typedef struct Timer Timer;
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "cpu.h"
@@ -11,10 +12,13 @@ typedef struct Timer Timer;
 struct Timer {
     int divCounter;
     int timaCounter;
+
+    // Decoded TAC, updated when TAC is written
+    bool timaEnabled;
+    int timaInterval;
 };
 
-void TIMER_init(Timer* timer);
-void TIMER_destroy(Timer* timer);
+void TIMER_init(Timer* timer, Memory* mem);
 void TIMER_update(CPU* cpu, Memory* mem, Timer* timer);
 
 #endif
\ No newline at end of file
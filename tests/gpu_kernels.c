@@ -0,0 +1,115 @@
+// Checks every tile decoder and palette kernel the CPU can run against the scalar versions. Built with gpu.c included
+// so the static kernels are reachable: make test
+#include "../src/gpu.c"
+
+#define ROUNDS 100000
+#define GUARD 64 // bytes past the end of every output that no kernel may write
+
+typedef struct {
+    const char* name;
+    void (*decode)(uint8_t* pixels, const uint8_t* data);
+} TileKernel;
+
+typedef struct {
+    const char* name;
+    void (*apply)(uint8_t* target, const uint8_t* colors, const uint32_t* palette, int count);
+} PaletteKernel;
+
+static uint32_t nextRandom(uint32_t* state);
+static bool testTiles(const TileKernel* kernel);
+static bool testPalettes(const PaletteKernel* kernel);
+
+int main(void) {
+    TileKernel tileKernels[2];
+    PaletteKernel paletteKernels[3];
+    int tileKernelsNo = 0;
+    int paletteKernelsNo = 0;
+    #if defined(__x86_64__) && defined(__GNUC__)
+    tileKernels[tileKernelsNo++] = (TileKernel) {"sse2", decodeTileSse2};
+    if (__builtin_cpu_supports("ssse3")) {
+        paletteKernels[paletteKernelsNo++] = (PaletteKernel) {"ssse3", applyPaletteSsse3};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        paletteKernels[paletteKernelsNo++] = (PaletteKernel) {"avx2", applyPaletteAvx2};
+    }
+    #elif defined(__aarch64__) && defined(__ARM_NEON)
+    tileKernels[tileKernelsNo++] = (TileKernel) {"neon", decodeTileNeon};
+    paletteKernels[paletteKernelsNo++] = (PaletteKernel) {"neon", applyPaletteNeon};
+    #endif
+
+    // The selected kernels as well, in case selectKernels picks something not listed above
+    pthread_once(&kernelsOnce, selectKernels);
+    tileKernels[tileKernelsNo++] = (TileKernel) {"selected", decodeTile};
+    paletteKernels[paletteKernelsNo++] = (PaletteKernel) {"selected", applyPalette};
+
+    bool passed = true;
+    for (int i = 0; i < tileKernelsNo; ++i) {
+        passed &= testTiles(&(tileKernels[i]));
+    }
+    for (int i = 0; i < paletteKernelsNo; ++i) {
+        passed &= testPalettes(&(paletteKernels[i]));
+    }
+    return passed ? 0 : 1;
+}
+
+// xorshift32, so every run checks the same inputs
+static uint32_t nextRandom(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static bool testTiles(const TileKernel* kernel) {
+    uint32_t state = 0x9BBC0F;
+    uint8_t data[16];
+    uint8_t expected[64];
+    uint8_t actual[64 + GUARD];
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < 16; ++i) {
+            data[i] = nextRandom(&state);
+        }
+        decodeTileScalar(expected, data);
+        memset(actual, 0xAA, sizeof(actual));
+        kernel->decode(actual, data);
+        for (int i = 0; i < (int) sizeof(actual); ++i) {
+            if (actual[i] != (i < 64 ? expected[i] : 0xAA)) {
+                fprintf(stderr, "decodeTile %s: round %d differs from the scalar version at byte %d\n", kernel->name, round, i);
+                return false;
+            }
+        }
+    }
+    printf("decodeTile %s: ok\n", kernel->name);
+    return true;
+}
+
+// Random palettes and colors, with every count a scanline can need and unaligned starts like SCX % 8 gives
+static bool testPalettes(const PaletteKernel* kernel) {
+    uint32_t state = 0x306230;
+    uint32_t palette[4];
+    uint8_t colors[GB_SCREEN_WIDTH + 8];
+    uint8_t expected[GB_SCREEN_WIDTH * 4];
+    uint8_t actual[(GB_SCREEN_WIDTH * 4) + GUARD];
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            palette[i] = nextRandom(&state);
+        }
+        for (int i = 0; i < (int) sizeof(colors); ++i) {
+            colors[i] = nextRandom(&state) & 0x3;
+        }
+        int offset = round % 8;
+        int count = round % (GB_SCREEN_WIDTH + 1);
+        applyPaletteScalar(expected, colors + offset, palette, count);
+        memset(actual, 0xAA, sizeof(actual));
+        kernel->apply(actual, colors + offset, palette, count);
+        for (int i = 0; i < (count * 4) + GUARD; ++i) {
+            if (actual[i] != (i < count * 4 ? expected[i] : 0xAA)) {
+                fprintf(stderr, "applyPalette %s: round %d (%d pixels) differs from the scalar version at byte %d\n",
+                        kernel->name, round, count, i);
+                return false;
+            }
+        }
+    }
+    printf("applyPalette %s: ok\n", kernel->name);
+    return true;
+}
@@ -0,0 +1,81 @@
+// Checks that an incremental save which failed to reach disk is still written when its retry finds the I/O queue
+// full and battery RAM does not change again before the save file is closed: make test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/io.h"
+#include "../src/save.h"
+
+#define SAVE_SIZE 0x2000
+
+static void waitForPipe(void* context);
+static void doNothing(void* context);
+
+int main(void) {
+    char dir[] = "/tmp/save_retryXXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror("Could not create a temporary directory");
+        exit(1);
+    }
+    char romPath[64];
+    char savePath[sizeof(romPath) + 4];
+    char tmpPath[sizeof(savePath) + 4];
+    snprintf(romPath, sizeof(romPath), "%s/game.gb", dir);
+    snprintf(savePath, sizeof(savePath), "%s.sav", romPath);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", savePath);
+
+    IOWorker* io = malloc(sizeof(*io)); // freed in IO_destroy
+    IO_init(io, 2);
+    SaveFile save;
+    uint8_t* ram = SAVE_open(&save, romPath, SAVE_SIZE, SAVE_INCREMENTAL, io);
+
+    // A directory where the temp file should be makes the first save fail
+    mkdir(tmpPath, 0755);
+    memset(ram + 0x300, 0x5A, 0x100);
+    SAVE_markPageDirty(&save, 0x300);
+    SAVE_sync(&save);
+    IO_flush(io);
+    rmdir(tmpPath);
+
+    // Hold the I/O thread and fill the queue behind it, so the retry cannot be queued
+    int blocker[2];
+    if (pipe(blocker) != 0) {
+        perror("Could not create a pipe");
+        exit(1);
+    }
+    IO_submit(io, waitForPipe, &(blocker[0]));
+    while (IO_trySubmit(io, doNothing, NULL));
+    SAVE_sync(&save);
+    close(blocker[1]);
+
+    SAVE_close(&save);
+    IO_destroy(io);
+    close(blocker[0]);
+
+    uint8_t written[SAVE_SIZE] = {0};
+    FILE* file = fopen(savePath, "rb");
+    size_t size = file != NULL ? fread(written, 1, sizeof(written), file) : 0;
+    if (file != NULL) fclose(file);
+    unlink(savePath);
+    unlink(tmpPath);
+    rmdir(dir);
+
+    if (size != SAVE_SIZE || written[0x350] != 0x5A) {
+        fprintf(stderr, "save retry: the failed save never reached %s (%zu bytes on disk)\n", savePath, size);
+        return 1;
+    }
+    printf("save retry: ok\n");
+    return 0;
+}
+
+// I/O thread: block until the write end of the pipe is closed
+static void waitForPipe(void* context) {
+    uint8_t byte;
+    while (read(*(int*) context, &byte, 1) > 0);
+}
+
+static void doNothing(void* context) {
+}